@@ -0,0 +1,1135 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * KUnit tests for the s6e3fc3_6a panel driver.
+ *
+ * The driver source is built into this module so its static command tables
+ * and callbacks can be driven against a mock DSI host, its tracepoints come
+ * from the driver module. The host decodes the command stream into a model of
+ * the panel registers: the F0/F1 test key locks, the 0xB0 global parameter
+ * offset and its width, which the 0xF2 8/10-bit switch selects, the 0xF7
+ * freq_update latch, sleep and display on/off. Reads return the register
+ * contents of the model, the power mode is computed from the sleep and display
+ * state unless a latch-up is modelled.
+ *
+ * Copyright 2021 Google LLC
+ */
+
+#include <kunit/test.h>
+#include <linux/regulator/consumer.h>
+#include <linux/vmalloc.h>
+
+#define s6e3fc3_6a_KUNIT_TEST
+#include "panel-samsung-s6e3fc3_6a.c"
+
+/* registers written through 0xB0 go up to the LHBM gamma at offset 0x3CD of 0x65 */
+#define s6e3fc3_6a_TEST_REG_LEN		0x3E0
+/* modelled bus cost: HS byte time on 4 lanes and one LP/HS turnaround */
+#define s6e3fc3_6a_TEST_BYTE_NS		2
+#define s6e3fc3_6a_TEST_TURNAROUND_NS	10000
+
+struct s6e3fc3_6a_test_model {
+	/** @f0_unlocked: F0 test key is open */
+	bool f0_unlocked;
+	/** @f1_unlocked: F1 test key is open */
+	bool f1_unlocked;
+	/** @locked_writes: level 2 registers written without the F0 key */
+	u32 locked_writes;
+	/** @offset_reg: register the pending 0xB0 offset applies to */
+	u8 offset_reg;
+	/** @offset: pending 0xB0 offset, consumed by the next write */
+	u16 offset;
+	/** @width_errors: 0xB0 offsets not matching the 8/10-bit mode of 0xF2 */
+	u32 width_errors;
+	/** @latches: freq_update writes */
+	u32 latches;
+	/** @sleep_out: panel is out of sleep */
+	bool sleep_out;
+	/** @display_on: display is on */
+	bool display_on;
+	/** @sleep_ins: sleep in commands */
+	u32 sleep_ins;
+	/**
+	 * @latched_up: power mode reads 0 until the next sleep in, which stands for
+	 * the reset line and regulators the mock cannot see
+	 */
+	bool latched_up;
+	/** @dead: power mode reads 0 whatever is sent */
+	bool dead;
+	/** @regs: contents of the 256 registers, indexed by global parameter offset */
+	u8 (*regs)[s6e3fc3_6a_TEST_REG_LEN];
+};
+
+struct s6e3fc3_6a_test_bus {
+	/** @writes: packets written by the host, including PPS and compression mode */
+	u32 writes;
+	/** @reads: DCS reads */
+	u32 reads;
+	/** @transfers: bursts, closed by a read or a write without EXYNOS_DSI_MSG_QUEUE */
+	u32 transfers;
+	/** @wire_bytes: packet bytes including DSI headers and CRC */
+	u32 wire_bytes;
+	/** @log: payloads of all writes, back to back */
+	u8 log[1024];
+	/** @log_len: bytes used in @log */
+	size_t log_len;
+	/** @pps: payload of the last PPS packet */
+	u8 pps[sizeof(struct drm_dsc_picture_parameter_set)];
+	/** @pps_len: length of the last PPS packet */
+	size_t pps_len;
+};
+
+struct s6e3fc3_6a_test {
+	struct mipi_dsi_host host;
+	struct mipi_dsi_device dsi;
+	struct s6e3fc3_6a_panel spanel;
+	struct s6e3fc3_6a_test_model model;
+	struct s6e3fc3_6a_test_bus bus;
+};
+
+static const u32 s6e3fc3_6a_test_revs[] = {
+	PANEL_REV_PROTO1, PANEL_REV_PROTO1_1, PANEL_REV_EVT1, PANEL_REV_EVT1_1,
+	PANEL_REV_DVT1, PANEL_REV_PVT, PANEL_REV_MP,
+};
+
+/* 0xF2 at offset 0x28 switches the 0xB0 offset from 8 to 10 bits */
+static bool s6e3fc3_6a_test_ten_bit(const struct s6e3fc3_6a_test_model *model)
+{
+	return model->regs[0xF2][0x28] == 0xCC;
+}
+
+static void s6e3fc3_6a_test_decode(struct s6e3fc3_6a_test_model *model,
+				   const u8 *d, size_t len)
+{
+	size_t off = 0;
+
+	switch (d[0]) {
+	case 0xF0:
+		model->f0_unlocked = len == 3 && d[1] == 0x5A && d[2] == 0x5A;
+		return;
+	case 0xF1:
+		model->f1_unlocked = len == 3 && d[1] == 0x5A && d[2] == 0x5A;
+		return;
+	case 0xB0:
+		/* 8-bit offset + register, or 16-bit offset + register in 10-bit mode */
+		if (len != (s6e3fc3_6a_test_ten_bit(model) ? 4 : 3))
+			model->width_errors++;
+		model->offset = len == 3 ? d[1] : (d[1] << 8) | d[2];
+		model->offset_reg = d[len - 1];
+		return;
+	case 0xF7:
+		model->latches++;
+		break;
+	case MIPI_DCS_ENTER_SLEEP_MODE:
+		model->sleep_out = false;
+		model->sleep_ins++;
+		model->latched_up = false;
+		break;
+	case MIPI_DCS_EXIT_SLEEP_MODE:
+		model->sleep_out = true;
+		break;
+	case MIPI_DCS_SET_DISPLAY_OFF:
+		model->display_on = false;
+		break;
+	case MIPI_DCS_SET_DISPLAY_ON:
+		model->display_on = true;
+		break;
+	}
+
+	/* 0xC2 PPS_MIC_OFF is sent without the key by the vendor enable sequence */
+	if (d[0] >= 0xB0 && d[0] != 0xC2 && !model->f0_unlocked)
+		model->locked_writes++;
+
+	if (model->offset_reg == d[0])
+		off = model->offset;
+	model->offset_reg = 0;
+	model->offset = 0;
+
+	if (off + len - 1 <= s6e3fc3_6a_TEST_REG_LEN)
+		memcpy(&model->regs[d[0]][off], &d[1], len - 1);
+}
+
+/* a read consumes the pending 0xB0 offset like a write does */
+static ssize_t s6e3fc3_6a_test_read(struct s6e3fc3_6a_test_model *model,
+				    const struct mipi_dsi_msg *msg)
+{
+	const u8 reg = *(const u8 *)msg->tx_buf;
+	size_t off = 0;
+
+	if (model->offset_reg == reg)
+		off = model->offset;
+	model->offset_reg = 0;
+	model->offset = 0;
+
+	if (reg == MIPI_DCS_GET_POWER_MODE && msg->rx_len == 1) {
+		u8 *mode = msg->rx_buf;
+
+		*mode = 0;
+		if (model->latched_up || model->dead)
+			return 1;
+		if (model->sleep_out)
+			*mode |= MIPI_DCS_POWER_MODE_SLEEP_MODE;
+		if (model->display_on)
+			*mode |= MIPI_DCS_POWER_MODE_DISPLAY;
+		return 1;
+	}
+
+	if (off + msg->rx_len > s6e3fc3_6a_TEST_REG_LEN)
+		return -EINVAL;
+
+	memcpy(msg->rx_buf, &model->regs[reg][off], msg->rx_len);
+
+	return msg->rx_len;
+}
+
+static ssize_t s6e3fc3_6a_test_transfer(struct mipi_dsi_host *host,
+					const struct mipi_dsi_msg *msg)
+{
+	struct s6e3fc3_6a_test *t = container_of(host, struct s6e3fc3_6a_test, host);
+	struct s6e3fc3_6a_test_bus *bus = &t->bus;
+
+	if (msg->type == MIPI_DSI_DCS_READ) {
+		bus->reads++;
+		bus->transfers++;
+		return s6e3fc3_6a_test_read(&t->model, msg);
+	}
+
+	bus->writes++;
+	if (!(msg->flags & EXYNOS_DSI_MSG_QUEUE))
+		bus->transfers++;
+	bus->wire_bytes += msg->tx_len <= 2 ? s6e3fc3_6a_DSI_SHORT_PKT_BYTES :
+			   msg->tx_len + s6e3fc3_6a_DSI_LONG_PKT_OVERHEAD;
+	if (bus->log_len + msg->tx_len <= sizeof(bus->log)) {
+		memcpy(&bus->log[bus->log_len], msg->tx_buf, msg->tx_len);
+		bus->log_len += msg->tx_len;
+	}
+
+	if (msg->type == MIPI_DSI_PICTURE_PARAMETER_SET) {
+		bus->pps_len = min(msg->tx_len, sizeof(bus->pps));
+		memcpy(bus->pps, msg->tx_buf, bus->pps_len);
+	}
+
+	/* PPS and compression mode are not part of the register model */
+	if (msg->type == MIPI_DSI_DCS_SHORT_WRITE ||
+	    msg->type == MIPI_DSI_DCS_SHORT_WRITE_PARAM ||
+	    msg->type == MIPI_DSI_DCS_LONG_WRITE)
+		s6e3fc3_6a_test_decode(&t->model, msg->tx_buf, msg->tx_len);
+
+	return msg->tx_len;
+}
+
+static const struct mipi_dsi_host_ops s6e3fc3_6a_test_host_ops = {
+	.transfer = s6e3fc3_6a_test_transfer,
+};
+
+static void s6e3fc3_6a_test_release(struct device *dev)
+{
+}
+
+/*
+ * The mock DSI device is a KUnit resource: everything devm allocated on it
+ * during a case is released through a devres group before the last reference
+ * is dropped, put_device() alone leaves that to the driver core.
+ */
+static int s6e3fc3_6a_test_dev_init(struct kunit_resource *res, void *context)
+{
+	struct device *dev = context;
+
+	device_initialize(dev);
+	dev->release = s6e3fc3_6a_test_release;
+	dev_set_name(dev, "s6e3fc3_6a-test");
+	if (!devres_open_group(dev, NULL, GFP_KERNEL)) {
+		put_device(dev);
+		return -ENOMEM;
+	}
+	res->data = dev;
+
+	return 0;
+}
+
+static void s6e3fc3_6a_test_dev_free(struct kunit_resource *res)
+{
+	struct device *dev = res->data;
+
+	devres_release_group(dev, NULL);
+	put_device(dev);
+}
+
+static void s6e3fc3_6a_test_reset(struct s6e3fc3_6a_test *t, u32 panel_rev)
+{
+	u8 (*regs)[s6e3fc3_6a_TEST_REG_LEN] = t->model.regs;
+
+	memset(regs, 0, 256 * sizeof(*regs));
+	memset(&t->model, 0, sizeof(t->model));
+	t->model.regs = regs;
+	memset(&t->bus, 0, sizeof(t->bus));
+	memset(&t->spanel.shadow, 0, sizeof(t->spanel.shadow));
+	t->spanel.state.pending = 0;
+	t->spanel.base.panel_rev = panel_rev;
+}
+
+/* int rather than u8, KUNIT_EXPECT_EQ wants both sides of the same type */
+static int s6e3fc3_6a_test_reg(struct s6e3fc3_6a_test *t, u8 reg, u16 offset)
+{
+	return t->model.regs[reg][offset];
+}
+
+static u64 s6e3fc3_6a_test_bus_ns(const struct s6e3fc3_6a_test_bus *bus)
+{
+	return (u64)bus->wire_bytes * s6e3fc3_6a_TEST_BYTE_NS +
+	       (u64)bus->transfers * s6e3fc3_6a_TEST_TURNAROUND_NS;
+}
+
+static void s6e3fc3_6a_test_report(struct kunit *test, const char *op, u32 panel_rev)
+{
+	struct s6e3fc3_6a_test *t = test->priv;
+
+	kunit_info(test, "%s rev %#x: writes=%u transfers=%u wire_bytes=%u bus_us=%llu\n",
+		   op, panel_rev, t->bus.writes, t->bus.transfers, t->bus.wire_bytes,
+		   div_u64(s6e3fc3_6a_test_bus_ns(&t->bus), NSEC_PER_USEC));
+}
+
+/*
+ * The test keys are closed again, nothing protected was written without them
+ * and every 0xB0 offset had the width of the 8/10-bit mode it was sent in.
+ */
+static void s6e3fc3_6a_test_expect_locked(struct kunit *test)
+{
+	struct s6e3fc3_6a_test *t = test->priv;
+
+	KUNIT_EXPECT_FALSE(test, t->model.f0_unlocked);
+	KUNIT_EXPECT_FALSE(test, t->model.f1_unlocked);
+	KUNIT_EXPECT_EQ(test, t->model.locked_writes, 0U);
+	KUNIT_EXPECT_EQ(test, t->model.width_errors, 0U);
+}
+
+static void s6e3fc3_6a_test_init_cmd_set(struct kunit *test)
+{
+	struct s6e3fc3_6a_test *t = test->priv;
+	struct exynos_panel *ctx = &t->spanel.base;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(s6e3fc3_6a_test_revs); i++) {
+		const u32 rev = s6e3fc3_6a_test_revs[i];
+
+		s6e3fc3_6a_test_reset(t, rev);
+		s6e3fc3_6a_send_cmd_set_batched(ctx, &s6e3fc3_6a_init_cmd_set);
+		s6e3fc3_6a_test_report(test, "init", rev);
+
+		s6e3fc3_6a_test_expect_locked(test);
+		KUNIT_EXPECT_EQ(test, t->model.latches, 1U);
+
+		/* LHBM circle location, written in 10-bit mode and left in 8-bit mode */
+		KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, 0x68, 0x134), 0x21);
+		KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, 0x68, 0x135), 0xC6);
+		KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, 0x68, 0x136), 0xB3);
+		KUNIT_EXPECT_FALSE(test, s6e3fc3_6a_test_ten_bit(&t->model));
+
+		KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, 0x8F, 0x0B),
+				rev == PANEL_REV_PROTO1 ? 0x2B : 0x00);
+		KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, 0xF4, 0x0B),
+				rev < PANEL_REV_EVT1 ? 0x1C : 0x00);
+	}
+}
+
+static void s6e3fc3_6a_test_pwm_cmd_sets(struct kunit *test)
+{
+	static const struct {
+		const char *name;
+		const struct exynos_dsi_cmd_set *cmd_set;
+		u8 pulse[2];
+	} sets[] = {
+		{ "pwm_1", &s6e3fc3_6a_1_pwm_cmd_set, { 0x00, 0x72 } },
+		{ "pwm_4", &s6e3fc3_6a_4_pwm_cmd_set, { 0x01, 0xC4 } },
+	};
+	struct s6e3fc3_6a_test *t = test->priv;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(sets); i++) {
+		s6e3fc3_6a_test_reset(t, PANEL_REV_PROTO1_1);
+		s6e3fc3_6a_send_cmd_set_batched(&t->spanel.base, sets[i].cmd_set);
+		s6e3fc3_6a_test_report(test, sets[i].name, PANEL_REV_PROTO1_1);
+
+		s6e3fc3_6a_test_expect_locked(test);
+		KUNIT_EXPECT_EQ(test, t->model.latches, 1U);
+
+		KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, 0x65, 0x1F2), (int)sets[i].pulse[0]);
+		KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, 0x65, 0x1F3), (int)sets[i].pulse[1]);
+		KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, 0x65, 0x233), 0x01);
+		KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, 0x65, 0x234), 0x02);
+		KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, 0x65, 0x235), 0x22);
+		/*
+		 * 10-bit mode for the 0x65 writes. The sets end by writing 0xC4 to
+		 * FQ CON at offset 0x27 rather than to offset 0x28, so they leave
+		 * the panel in 10-bit mode.
+		 */
+		KUNIT_EXPECT_TRUE(test, s6e3fc3_6a_test_ten_bit(&t->model));
+		KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, 0xF2, 0x27), 0xC4);
+	}
+}
+
+static void s6e3fc3_6a_test_change_frequency(struct kunit *test)
+{
+	struct s6e3fc3_6a_test *t = test->priv;
+	struct exynos_panel *ctx = &t->spanel.base;
+
+	s6e3fc3_6a_test_reset(t, PANEL_REV_MP);
+	s6e3fc3_6a_change_frequency(ctx, 90);
+	s6e3fc3_6a_test_report(test, "freq 90", PANEL_REV_MP);
+
+	s6e3fc3_6a_test_expect_locked(test);
+	KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, 0x60, 0), 0x10);
+	KUNIT_EXPECT_EQ(test, t->model.latches, 1U);
+
+	/* the shadow cache drops a write of the rate the panel already runs at */
+	memset(&t->bus, 0, sizeof(t->bus));
+	s6e3fc3_6a_change_frequency(ctx, 90);
+	KUNIT_EXPECT_EQ(test, t->bus.writes, 0U);
+
+	s6e3fc3_6a_change_frequency(ctx, 60);
+	KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, 0x60, 0), 0x00);
+	KUNIT_EXPECT_EQ(test, t->model.latches, 2U);
+}
+
+static const u8 s6e3fc3_6a_test_gamma[] = { 0x65, 0x01, 0x02, 0x03, 0x04, 0x05 };
+
+static void s6e3fc3_6a_test_enable(struct kunit *test)
+{
+	struct s6e3fc3_6a_test *t = test->priv;
+	struct exynos_panel *ctx = &t->spanel.base;
+	int i;
+
+	BUILD_BUG_ON(sizeof(s6e3fc3_6a_test_gamma) != s6e3fc3_6a_LOCAL_HBM_GAMMA_CMD_SIZE);
+	memcpy(ctx->hbm.local_hbm.gamma_cmd, s6e3fc3_6a_test_gamma,
+	       sizeof(s6e3fc3_6a_test_gamma));
+	ctx->hbm.local_hbm.gamma_para_ready = true;
+
+	for (i = 0; i < ARRAY_SIZE(s6e3fc3_6a_test_revs); i++) {
+		const u32 rev = s6e3fc3_6a_test_revs[i];
+
+		s6e3fc3_6a_test_reset(t, rev);
+		ctx->enabled = false;
+		KUNIT_ASSERT_EQ(test, s6e3fc3_6a_enable(&ctx->panel), 0);
+		s6e3fc3_6a_test_report(test, "enable", rev);
+
+		s6e3fc3_6a_test_expect_locked(test);
+		KUNIT_EXPECT_TRUE(test, ctx->enabled);
+		KUNIT_EXPECT_TRUE(test, t->model.sleep_out);
+		KUNIT_EXPECT_TRUE(test, t->model.display_on);
+		KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, 0x60, 0), 0x00);
+		KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, MIPI_DCS_WRITE_CONTROL_DISPLAY, 0),
+				s6e3fc3_6a_WRCTRLD_BCTRL_BIT);
+		KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, 0x9D, 0), 0x01);
+
+		/* PWM on PROTO1.1, the LHBM gamma from EVT1.1 on */
+		KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, 0x65, 0x1F3),
+				rev == PANEL_REV_PROTO1_1 ? 0xC4 : 0x00);
+		KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, 0x65, 0x3CD),
+				rev >= PANEL_REV_EVT1_1 ? 0x01 : 0x00);
+		KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, 0x65, 0x3D1),
+				rev >= PANEL_REV_EVT1_1 ? 0x05 : 0x00);
+	}
+}
+
+static void s6e3fc3_6a_test_lp_mode(struct kunit *test)
+{
+	struct s6e3fc3_6a_test *t = test->priv;
+	struct exynos_panel *ctx = &t->spanel.base;
+	const struct exynos_panel_mode *pmode = ctx->current_mode;
+
+	s6e3fc3_6a_test_reset(t, PANEL_REV_MP);
+	t->model.display_on = true;
+	ctx->bl->props.brightness = ctx->desc->dft_brightness;
+
+	s6e3fc3_6a_set_lp_mode(ctx, ctx->desc->lp_mode);
+	ctx->current_mode = ctx->desc->lp_mode;
+	s6e3fc3_6a_test_report(test, "lp", PANEL_REV_MP);
+
+	/* the "high" bin: AOD 50 nit */
+	KUNIT_EXPECT_TRUE(test, t->model.display_on);
+	KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, MIPI_DCS_WRITE_CONTROL_DISPLAY, 0), 0x24);
+	KUNIT_EXPECT_EQ(test, t->spanel.aod.bin, 2);
+	KUNIT_EXPECT_NE(test, t->spanel.aod.lp_start, (ktime_t)0);
+
+	memset(&t->bus, 0, sizeof(t->bus));
+	t->model.latches = 0;
+	s6e3fc3_6a_set_nolp_mode(ctx, pmode);
+	ctx->current_mode = pmode;
+	s6e3fc3_6a_test_report(test, "nolp", PANEL_REV_MP);
+
+	s6e3fc3_6a_test_expect_locked(test);
+	KUNIT_EXPECT_TRUE(test, t->model.display_on);
+	KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, MIPI_DCS_WRITE_CONTROL_DISPLAY, 0),
+			s6e3fc3_6a_WRCTRLD_BCTRL_BIT);
+	KUNIT_EXPECT_EQ(test, t->model.latches, 1U);
+	KUNIT_EXPECT_EQ(test, t->spanel.aod.bin, -1);
+	KUNIT_EXPECT_EQ(test, t->spanel.aod.lp_start, (ktime_t)0);
+}
+
+/* PROTO1.1 also switches the PWM set, see s6e3fc3_6a_test_pwm_cmd_sets */
+static void s6e3fc3_6a_test_hbm_irc(struct kunit *test)
+{
+	struct s6e3fc3_6a_test *t = test->priv;
+	struct exynos_panel *ctx = &t->spanel.base;
+
+	s6e3fc3_6a_test_reset(t, PANEL_REV_MP);
+	ctx->hbm_mode = HBM_OFF;
+
+	s6e3fc3_6a_request_hbm_mode(ctx, HBM_ON_IRC_OFF, false);
+	s6e3fc3_6a_test_report(test, "hbm irc off", PANEL_REV_MP);
+	s6e3fc3_6a_test_expect_locked(test);
+	KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, 0x8F, 0x03), 0x05);
+	KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, MIPI_DCS_WRITE_CONTROL_DISPLAY, 0),
+			s6e3fc3_6a_WRCTRLD_BCTRL_BIT | s6e3fc3_6a_WRCTRLD_HBM_BIT);
+
+	/* only IRC changes */
+	memset(&t->bus, 0, sizeof(t->bus));
+	s6e3fc3_6a_request_hbm_mode(ctx, HBM_ON_IRC_ON, false);
+	s6e3fc3_6a_test_report(test, "hbm irc on", PANEL_REV_MP);
+	s6e3fc3_6a_test_expect_locked(test);
+	KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, 0x8F, 0x03), 0x25);
+	KUNIT_EXPECT_EQ(test, t->bus.transfers, 1U);
+
+	/* only WRCTRLD changes */
+	memset(&t->bus, 0, sizeof(t->bus));
+	s6e3fc3_6a_request_hbm_mode(ctx, HBM_OFF, false);
+	s6e3fc3_6a_test_report(test, "hbm off", PANEL_REV_MP);
+	KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, MIPI_DCS_WRITE_CONTROL_DISPLAY, 0),
+			s6e3fc3_6a_WRCTRLD_BCTRL_BIT);
+	KUNIT_EXPECT_EQ(test, t->bus.writes, 1U);
+}
+
+static void s6e3fc3_6a_test_local_hbm(struct kunit *test)
+{
+	struct s6e3fc3_6a_test *t = test->priv;
+	struct exynos_panel *ctx = &t->spanel.base;
+	int i;
+
+	s6e3fc3_6a_test_reset(t, PANEL_REV_MP);
+	for (i = 1; i < s6e3fc3_6a_LOCAL_HBM_GAMMA_CMD_SIZE; i++)
+		t->model.regs[0xD8][0x22 + i - 1] = s6e3fc3_6a_test_gamma[i];
+
+	KUNIT_EXPECT_EQ(test, s6e3fc3_6a_lhbm_gamma_read(ctx), 0);
+	s6e3fc3_6a_test_report(test, "lhbm gamma read", PANEL_REV_MP);
+	s6e3fc3_6a_test_expect_locked(test);
+	KUNIT_EXPECT_EQ(test, t->bus.reads, 1U);
+	KUNIT_EXPECT_TRUE(test, ctx->hbm.local_hbm.gamma_para_ready);
+	KUNIT_EXPECT_EQ(test, memcmp(ctx->hbm.local_hbm.gamma_cmd, s6e3fc3_6a_test_gamma,
+				     sizeof(s6e3fc3_6a_test_gamma)), 0);
+
+	s6e3fc3_6a_lhbm_gamma_write(ctx);
+	s6e3fc3_6a_test_expect_locked(test);
+	KUNIT_EXPECT_EQ(test, memcmp(&t->model.regs[0x65][0x3CD], &s6e3fc3_6a_test_gamma[1],
+				     sizeof(s6e3fc3_6a_test_gamma) - 1), 0);
+
+	s6e3fc3_6a_set_local_hbm_mode(ctx, true);
+	KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, MIPI_DCS_WRITE_CONTROL_DISPLAY, 0),
+			s6e3fc3_6a_WRCTRLD_BCTRL_BIT | s6e3fc3_6a_WRCTRLD_LOCAL_HBM_BIT);
+	s6e3fc3_6a_set_local_hbm_mode(ctx, false);
+	KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, MIPI_DCS_WRITE_CONTROL_DISPLAY, 0),
+			s6e3fc3_6a_WRCTRLD_BCTRL_BIT);
+}
+
+static void s6e3fc3_6a_test_te2_setting(struct kunit *test)
+{
+	static const struct {
+		u32 rising, falling;
+		u8 setting[s6e3fc3_6a_TE2_SETTING_LEN];
+	} cases[] = {
+		{ 0, 0, { 0x00, 0x00, 0x00 } },
+		{ 0, 0xFFF, { 0x0F, 0x00, 0xFF } },
+		{ 0xFFF, 0xFFF, { 0xF0, 0xFF, 0x00 } },
+		{ 0xFFF, 0xFFF + 0xFFF, { 0xFF, 0xFF, 0xFF } },
+		{ 0x123, 0x123 + 0x456, { 0x14, 0x23, 0x56 } },
+		/* overflowing delay and width clamp to 0xFFF */
+		{ 0x1000, 0x1000, { 0xF0, 0xFF, 0x00 } },
+		{ 0, 0x1000, { 0x0F, 0x00, 0xFF } },
+		{ U32_MAX, U32_MAX, { 0xF0, 0xFF, 0x00 } },
+		/* falling before rising is an empty pulse */
+		{ 0x20, 0x10, { 0x00, 0x20, 0x00 } },
+	};
+	const struct s6e3fc3_6a_te2_reg *lp = NULL;
+	struct exynos_panel_te2_timing timing;
+	u8 setting[s6e3fc3_6a_TE2_SETTING_LEN];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(cases); i++) {
+		timing.rising_edge = cases[i].rising;
+		timing.falling_edge = cases[i].falling;
+		memset(setting, 0xAA, sizeof(setting));
+		s6e3fc3_6a_get_te2_setting(&timing, setting);
+		KUNIT_EXPECT_EQ_MSG(test, memcmp(setting, cases[i].setting, sizeof(setting)), 0,
+				    "rising %#x falling %#x: %*ph", cases[i].rising,
+				    cases[i].falling, (int)sizeof(setting), setting);
+	}
+
+	/* the default of each TE2 option encodes the timing it stands for */
+	for (i = 0; i < ARRAY_SIZE(s6e3fc3_6a_te2_regs); i++) {
+		const u8 *dft = s6e3fc3_6a_te2_regs[i].dft;
+
+		timing.rising_edge = ((dft[0] >> 4) << 8) | dft[1];
+		timing.falling_edge = timing.rising_edge + (((dft[0] & 0xF) << 8) | dft[2]);
+		s6e3fc3_6a_get_te2_setting(&timing, setting);
+		KUNIT_EXPECT_EQ_MSG(test, memcmp(setting, dft, sizeof(setting)), 0,
+				    "%uhz%s", s6e3fc3_6a_te2_regs[i].vrefresh,
+				    s6e3fc3_6a_te2_regs[i].lp ? " lp" : "");
+	}
+
+	/* and the LP default matches the edges of the binned LP modes */
+	for (i = 0; i < ARRAY_SIZE(s6e3fc3_6a_te2_regs); i++)
+		if (s6e3fc3_6a_te2_regs[i].lp)
+			lp = &s6e3fc3_6a_te2_regs[i];
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, lp);
+	for (i = 0; i < ARRAY_SIZE(s6e3fc3_6a_binned_lp); i++) {
+		const struct exynos_binned_lp *binned_lp = &s6e3fc3_6a_binned_lp[i];
+
+		if (!binned_lp->te2_timing.falling_edge)
+			continue;
+		timing = binned_lp->te2_timing;
+		s6e3fc3_6a_get_te2_setting(&timing, setting);
+		KUNIT_EXPECT_EQ_MSG(test, memcmp(setting, lp->dft, sizeof(setting)), 0,
+				    "%s", binned_lp->name);
+	}
+
+	/* no timing or no buffer, nothing is written */
+	memset(setting, 0xAA, sizeof(setting));
+	s6e3fc3_6a_get_te2_setting(NULL, setting);
+	KUNIT_EXPECT_EQ(test, (int)setting[0], 0xAA);
+	s6e3fc3_6a_get_te2_setting(&timing, NULL);
+}
+
+static void s6e3fc3_6a_test_te2(struct kunit *test)
+{
+	struct s6e3fc3_6a_test *t = test->priv;
+	struct exynos_panel *ctx = &t->spanel.base;
+
+	s6e3fc3_6a_test_reset(t, PANEL_REV_MP);
+	/* 60hz: rising 0, falling 48; 90hz: rising 16, falling 64 */
+	ctx->te2.mode_data[0].timing.rising_edge = 0;
+	ctx->te2.mode_data[0].timing.falling_edge = 48;
+	ctx->te2.mode_data[1].timing.rising_edge = 16;
+	ctx->te2.mode_data[1].timing.falling_edge = 64;
+
+	s6e3fc3_6a_update_te2(ctx);
+	s6e3fc3_6a_test_report(test, "te2", PANEL_REV_MP);
+
+	s6e3fc3_6a_test_expect_locked(test);
+	KUNIT_EXPECT_FALSE(test, s6e3fc3_6a_test_ten_bit(&t->model));
+	KUNIT_EXPECT_EQ(test, t->model.latches, 1U);
+	KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, 0xF2, 0x26), 0x03);
+	KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, 0xCB, 0xAF), 0x00);
+	KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, 0xCB, 0xB0), 0x00);
+	KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, 0xCB, 0xB1), 0x30);
+	KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, 0xCB, 0x12F), 0x00);
+	KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, 0xCB, 0x130), 0x10);
+	KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, 0xCB, 0x131), 0x30);
+
+	/* unchanged edges are not written again */
+	memset(&t->bus, 0, sizeof(t->bus));
+	s6e3fc3_6a_update_te2(ctx);
+	KUNIT_EXPECT_EQ(test, t->bus.writes, 0U);
+
+	/* P1.0 has no TE2 */
+	s6e3fc3_6a_test_reset(t, PANEL_REV_PROTO1);
+	s6e3fc3_6a_update_te2(ctx);
+	KUNIT_EXPECT_EQ(test, t->bus.writes, 0U);
+}
+
+/*
+ * The generated PPS of every mode using the 2x48 slice layout of the vendor
+ * PPS must be bit identical to it, both as packed and as sent to the panel.
+ */
+static void s6e3fc3_6a_test_pps(struct kunit *test)
+{
+	struct s6e3fc3_6a_test *t = test->priv;
+	struct exynos_panel *ctx = &t->spanel.base;
+	const struct exynos_panel_desc *desc = ctx->desc;
+	const int num_modes = desc->num_modes + (desc->lp_mode ? 1 : 0);
+	struct s6e3fc3_6a_pps pps;
+	int i, j, checked = 0;
+
+	KUNIT_ASSERT_EQ(test, (int)sizeof(pps.pps), (int)sizeof(PPS_SETTING));
+
+	for (i = 0; i < num_modes; i++) {
+		const struct exynos_panel_mode *pmode =
+			i < desc->num_modes ? &desc->modes[i] : desc->lp_mode;
+		const u8 *packed = (const u8 *)&pps.pps;
+
+		if (pmode->exynos_mode.dsc.slice_count != 2 ||
+		    pmode->exynos_mode.dsc.slice_height != 48)
+			continue;
+
+		KUNIT_ASSERT_EQ(test, s6e3fc3_6a_pps_generate(ctx->dev, pmode, &pps), 0);
+		for (j = 0; j < sizeof(PPS_SETTING); j++)
+			if (packed[j] != PPS_SETTING[j])
+				break;
+		if (j < sizeof(PPS_SETTING))
+			KUNIT_FAIL(test, "%s: byte %d is %#04x, vendor PPS has %#04x",
+				   pmode->mode.name, j, packed[j], PPS_SETTING[j]);
+		checked++;
+	}
+	KUNIT_EXPECT_GT(test, checked, 0);
+
+	/* probe keeps the generated PPS and enable sends it */
+	KUNIT_ASSERT_EQ(test, s6e3fc3_6a_pps_init(ctx->dev, &t->spanel, desc), 0);
+	KUNIT_EXPECT_EQ(test, t->spanel.num_pps, num_modes);
+	for (i = 0; i < num_modes; i++) {
+		const struct exynos_panel_mode *pmode =
+			i < desc->num_modes ? &desc->modes[i] : desc->lp_mode;
+
+		if (pmode->exynos_mode.dsc.slice_count != 2 ||
+		    pmode->exynos_mode.dsc.slice_height != 48)
+			continue;
+
+		s6e3fc3_6a_test_reset(t, PANEL_REV_MP);
+		s6e3fc3_6a_pps_write(ctx, pmode);
+		KUNIT_EXPECT_EQ(test, t->bus.pps_len, sizeof(PPS_SETTING));
+		KUNIT_EXPECT_EQ_MSG(test, memcmp(t->bus.pps, PPS_SETTING, sizeof(PPS_SETTING)), 0,
+				    "%s", pmode->mode.name);
+	}
+}
+
+/**
+ * struct s6e3fc3_6a_test_frame - one compositor frame of a replayed workload
+ */
+struct s6e3fc3_6a_test_frame {
+	/** @name: frame name in the report */
+	const char *name;
+	/** @hbm: HBM mode set during the frame, or -1 to leave it */
+	int hbm;
+	/** @brightness: brightness set during the frame, or 0 to leave it */
+	u16 brightness;
+	/** @transfers: expected bursts on the bus, per revision */
+	u32 transfers;
+	/** @writes: expected packets written */
+	u32 writes;
+};
+
+/*
+ * Replays @frames the way the common driver drives them: the callbacks of a
+ * frame run under mode_lock, then commit_done hands the pending state to the
+ * flush work, which is waited for before the bus is checked.
+ */
+static void s6e3fc3_6a_test_replay(struct kunit *test, u32 panel_rev,
+				   const struct s6e3fc3_6a_test_frame *frames, int num_frames)
+{
+	struct s6e3fc3_6a_test *t = test->priv;
+	struct exynos_panel *ctx = &t->spanel.base;
+	int i;
+
+	for (i = 0; i < num_frames; i++) {
+		const struct s6e3fc3_6a_test_frame *f = &frames[i];
+
+		memset(&t->bus, 0, sizeof(t->bus));
+		mutex_lock(&ctx->mode_lock);
+		if (f->hbm >= 0)
+			s6e3fc3_6a_set_hbm_mode(ctx, f->hbm);
+		if (f->brightness)
+			s6e3fc3_6a_set_brightness(ctx, f->brightness);
+		s6e3fc3_6a_commit_done(ctx);
+		mutex_unlock(&ctx->mode_lock);
+		flush_delayed_work(&t->spanel.state.flush_work);
+		s6e3fc3_6a_test_report(test, f->name, panel_rev);
+
+		KUNIT_EXPECT_EQ_MSG(test, t->bus.transfers, f->transfers, "%s", f->name);
+		KUNIT_EXPECT_EQ_MSG(test, t->bus.writes, f->writes, "%s", f->name);
+		KUNIT_EXPECT_EQ(test, t->spanel.state.pending, 0U);
+	}
+}
+
+/*
+ * Enable followed by HBM and brightness changes, the transfer counts are the
+ * bursts each step costs: one per frame however many registers change.
+ */
+static void s6e3fc3_6a_test_replay_enable_hbm(struct kunit *test)
+{
+	static const struct s6e3fc3_6a_test_frame mp[] = {
+		{ "hbm on", HBM_ON_IRC_ON, 3000, 1, 2 },	/* WRCTRLD, brightness */
+		{ "irc off", HBM_ON_IRC_OFF, 0, 1, 4 },		/* key, IRC, key */
+		{ "hbm off", HBM_OFF, 1000, 1, 6 },		/* the above and WRCTRLD, brightness */
+		{ "brightness", -1, 1200, 1, 1 },
+		{ "idle", -1, 0, 0, 0 },
+	};
+	/* the HBM switch also sends the PWM set, in the same burst */
+	static const struct s6e3fc3_6a_test_frame proto1_1[] = {
+		{ "hbm on", HBM_ON_IRC_ON, 3000, 1, 17 },
+		{ "irc off", HBM_ON_IRC_OFF, 0, 1, 4 },
+		{ "hbm off", HBM_OFF, 1000, 1, 19 },
+		{ "brightness", -1, 1200, 1, 1 },
+		{ "idle", -1, 0, 0, 0 },
+	};
+	static const struct {
+		u32 panel_rev;
+		/* sleep out, init, frequency, DSC mode, PPS, PPS enable, WRCTRLD, display on */
+		u32 enable_transfers;
+		u32 enable_writes;
+		const struct s6e3fc3_6a_test_frame *frames;
+		int num_frames;
+	} replays[] = {
+		{ PANEL_REV_MP, 8, 27, mp, ARRAY_SIZE(mp) },
+		/* plus the PWM set, and the pre-EVT1 init commands */
+		{ PANEL_REV_PROTO1_1, 9, 45, proto1_1, ARRAY_SIZE(proto1_1) },
+	};
+	struct s6e3fc3_6a_test *t = test->priv;
+	struct exynos_panel *ctx = &t->spanel.base;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(replays); i++) {
+		const u32 rev = replays[i].panel_rev;
+
+		s6e3fc3_6a_test_reset(t, rev);
+		ctx->enabled = false;
+		ctx->hbm_mode = HBM_OFF;
+		KUNIT_ASSERT_EQ(test, s6e3fc3_6a_enable(&ctx->panel), 0);
+		s6e3fc3_6a_test_report(test, "enable", rev);
+		KUNIT_EXPECT_EQ(test, t->bus.transfers, replays[i].enable_transfers);
+		KUNIT_EXPECT_EQ(test, t->bus.writes, replays[i].enable_writes);
+		KUNIT_EXPECT_EQ(test, t->bus.reads, 0U);
+
+		s6e3fc3_6a_test_replay(test, rev, replays[i].frames, replays[i].num_frames);
+		KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, MIPI_DCS_SET_DISPLAY_BRIGHTNESS, 0),
+				1200 >> 8);
+		KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, MIPI_DCS_SET_DISPLAY_BRIGHTNESS, 1),
+				1200 & 0xFF);
+		KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, 0x8F, 0x03), 0x25);
+	}
+}
+
+struct s6e3fc3_6a_test_listener {
+	/** @nb: registered with s6e3fc3_6a_register_notifier() */
+	struct notifier_block nb;
+	/** @events: s6e3fc3_6a_NOTIFY_STATE events received */
+	u32 events;
+	/** @last: data of the last event */
+	struct s6e3fc3_6a_notify_data last;
+};
+
+static int s6e3fc3_6a_test_notifier_call(struct notifier_block *nb, unsigned long event,
+					 void *data)
+{
+	struct s6e3fc3_6a_test_listener *l =
+		container_of(nb, struct s6e3fc3_6a_test_listener, nb);
+
+	if (event != s6e3fc3_6a_NOTIFY_STATE)
+		return NOTIFY_DONE;
+
+	l->events++;
+	l->last = *(const struct s6e3fc3_6a_notify_data *)data;
+
+	return NOTIFY_OK;
+}
+
+static void s6e3fc3_6a_test_notifier(struct kunit *test)
+{
+	struct s6e3fc3_6a_test *t = test->priv;
+	struct exynos_panel *ctx = &t->spanel.base;
+	const struct exynos_panel_mode *pmode = ctx->current_mode;
+	struct s6e3fc3_6a_test_listener *l;
+	u32 events;
+
+	l = kunit_kzalloc(test, sizeof(*l), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, l);
+	l->nb.notifier_call = s6e3fc3_6a_test_notifier_call;
+	KUNIT_ASSERT_EQ(test, s6e3fc3_6a_register_notifier(&l->nb), 0);
+
+	s6e3fc3_6a_test_reset(t, PANEL_REV_MP);
+	ctx->bl->props.brightness = ctx->desc->dft_brightness;
+
+	/* frequency changes */
+	s6e3fc3_6a_change_frequency(ctx, 60);
+	KUNIT_EXPECT_EQ(test, l->events, 1U);
+	KUNIT_EXPECT_PTR_EQ(test, l->last.dev, ctx->dev);
+	KUNIT_EXPECT_EQ(test, l->last.vrefresh, 60U);
+	KUNIT_EXPECT_EQ(test, l->last.te_period_us, (u32)(USEC_PER_SEC / 60));
+	KUNIT_EXPECT_FALSE(test, l->last.lp);
+
+	s6e3fc3_6a_change_frequency(ctx, 90);
+	KUNIT_EXPECT_EQ(test, l->events, 2U);
+	KUNIT_EXPECT_EQ(test, l->last.vrefresh, 90U);
+	KUNIT_EXPECT_EQ(test, l->last.te_period_us, (u32)(USEC_PER_SEC / 90));
+
+	/* nothing changed, no event */
+	s6e3fc3_6a_change_frequency(ctx, 90);
+	KUNIT_EXPECT_EQ(test, l->events, 2U);
+
+	/* a mode change is applied by the state flush */
+	s6e3fc3_6a_mode_set(ctx, pmode);
+	flush_delayed_work(&t->spanel.state.flush_work);
+	KUNIT_EXPECT_EQ(test, l->events, 3U);
+	KUNIT_EXPECT_EQ(test, l->last.vrefresh, (u32)drm_mode_vrefresh(&pmode->mode));
+
+	s6e3fc3_6a_request_hbm_mode(ctx, HBM_ON_IRC_ON, false);
+	KUNIT_EXPECT_EQ(test, l->events, 4U);
+	KUNIT_EXPECT_TRUE(test, l->last.hbm);
+	s6e3fc3_6a_request_hbm_mode(ctx, HBM_OFF, false);
+	KUNIT_EXPECT_EQ(test, l->events, 5U);
+	KUNIT_EXPECT_FALSE(test, l->last.hbm);
+
+	/* LP entry and exit */
+	events = l->events;
+	s6e3fc3_6a_set_lp_mode(ctx, ctx->desc->lp_mode);
+	ctx->current_mode = ctx->desc->lp_mode;
+	KUNIT_EXPECT_GT(test, l->events, events);
+	KUNIT_EXPECT_TRUE(test, l->last.lp);
+	KUNIT_EXPECT_EQ(test, l->last.vrefresh,
+			(u32)drm_mode_vrefresh(&ctx->desc->lp_mode->mode));
+
+	events = l->events;
+	s6e3fc3_6a_set_nolp_mode(ctx, pmode);
+	ctx->current_mode = pmode;
+	KUNIT_EXPECT_EQ(test, l->events, events + 1);
+	KUNIT_EXPECT_FALSE(test, l->last.lp);
+	KUNIT_EXPECT_EQ(test, l->last.vrefresh, (u32)drm_mode_vrefresh(&pmode->mode));
+
+	/* disable reports the panel off, without mode_lock held */
+	events = l->events;
+	s6e3fc3_6a_disable(&ctx->panel);
+	KUNIT_EXPECT_GT(test, l->events, events);
+	KUNIT_EXPECT_EQ(test, l->last.vrefresh, 0U);
+
+	KUNIT_EXPECT_EQ(test, t->spanel.notify.events, l->events);
+	KUNIT_EXPECT_EQ(test, s6e3fc3_6a_unregister_notifier(&l->nb), 0);
+}
+
+/* what exynos_panel_send_cmd_set() puts on the bus: one transfer per command */
+static void s6e3fc3_6a_test_send_unbatched(struct exynos_panel *ctx,
+					   const struct exynos_dsi_cmd_set *cmd_set)
+{
+	const struct exynos_dsi_cmd *c;
+
+	for (c = cmd_set->cmds; c < cmd_set->cmds + cmd_set->num_cmd; c++)
+		if (!c->panel_rev || (c->panel_rev & ctx->panel_rev))
+			s6e3fc3_6a_dcs_write_flags(ctx, c->cmd, c->cmd_len, 0);
+}
+
+/*
+ * Batching only changes where the bursts end: the commands and their bytes
+ * stay the same, and a burst is closed by each delay and by the last command.
+ */
+static void s6e3fc3_6a_test_batched_cmd_sets(struct kunit *test)
+{
+	static const struct {
+		const char *name[2];
+		const struct exynos_dsi_cmd_set *cmd_set;
+	} sets[] = {
+		{ { "init", "init batched" }, &s6e3fc3_6a_init_cmd_set },
+		{ { "pwm_1", "pwm_1 batched" }, &s6e3fc3_6a_1_pwm_cmd_set },
+		{ { "pwm_4", "pwm_4 batched" }, &s6e3fc3_6a_4_pwm_cmd_set },
+	};
+	struct s6e3fc3_6a_test *t = test->priv;
+	struct exynos_panel *ctx = &t->spanel.base;
+	const struct exynos_dsi_cmd *c;
+	u32 writes, delays;
+	size_t log_len;
+	u8 *log;
+	int i, j;
+
+	log = kunit_kzalloc(test, sizeof(t->bus.log), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, log);
+
+	for (i = 0; i < ARRAY_SIZE(sets); i++) {
+		for (j = 0; j < ARRAY_SIZE(s6e3fc3_6a_test_revs); j++) {
+			const u32 rev = s6e3fc3_6a_test_revs[j];
+
+			s6e3fc3_6a_test_reset(t, rev);
+			s6e3fc3_6a_test_send_unbatched(ctx, sets[i].cmd_set);
+			s6e3fc3_6a_test_report(test, sets[i].name[0], rev);
+			memcpy(log, t->bus.log, t->bus.log_len);
+			log_len = t->bus.log_len;
+			writes = t->bus.writes;
+
+			s6e3fc3_6a_test_reset(t, rev);
+			s6e3fc3_6a_send_cmd_set_batched(ctx, sets[i].cmd_set);
+			s6e3fc3_6a_test_report(test, sets[i].name[1], rev);
+
+			KUNIT_EXPECT_EQ(test, t->bus.writes, writes);
+			KUNIT_EXPECT_EQ(test, t->bus.log_len, log_len);
+			KUNIT_EXPECT_EQ(test, memcmp(t->bus.log, log, log_len), 0);
+
+			delays = 0;
+			for (c = sets[i].cmd_set->cmds;
+			     c < sets[i].cmd_set->cmds + sets[i].cmd_set->num_cmd; c++)
+				if (c->delay_ms && (!c->panel_rev || (c->panel_rev & rev)))
+					delays++;
+			KUNIT_EXPECT_LE(test, t->bus.transfers, delays + 1);
+		}
+	}
+}
+
+/*
+ * The ESD tiers against the modelled power mode: a restore for a fault the
+ * panel survives, the power cycle for a latch-up, and for a panel that stays
+ * faulty a failure per attempt until the watchdog gives up.
+ */
+static void s6e3fc3_6a_test_esd(struct kunit *test)
+{
+	struct s6e3fc3_6a_test *t = test->priv;
+	struct exynos_panel *ctx = &t->spanel.base;
+	struct s6e3fc3_6a_esd *esd = &t->spanel.esd;
+	int i;
+
+	s6e3fc3_6a_test_reset(t, PANEL_REV_MP);
+	ctx->enabled = false;
+	ctx->hbm_mode = HBM_OFF;
+	KUNIT_ASSERT_EQ(test, s6e3fc3_6a_enable(&ctx->panel), 0);
+	s6e3fc3_6a_request_hbm_mode(ctx, HBM_ON_IRC_OFF, false);
+	KUNIT_EXPECT_EQ(test, (int)s6e3fc3_6a_esd_check(ctx), (int)s6e3fc3_6a_ESD_NONE);
+
+	/* the power mode reads fine again once the state is re-sent */
+	memset(&t->bus, 0, sizeof(t->bus));
+	s6e3fc3_6a_esd_recover(ctx, s6e3fc3_6a_ESD_TE_LOST);
+	s6e3fc3_6a_test_report(test, "esd restore", PANEL_REV_MP);
+	s6e3fc3_6a_test_expect_locked(test);
+	KUNIT_EXPECT_EQ(test, esd->restored, 1U);
+	KUNIT_EXPECT_EQ(test, esd->resets, 0U);
+	KUNIT_EXPECT_EQ(test, t->model.sleep_ins, 0U);
+
+	/* a latch-up escalates to the power cycle, which restores HBM and IRC */
+	memset(&t->bus, 0, sizeof(t->bus));
+	t->model.latched_up = true;
+	KUNIT_EXPECT_EQ(test, (int)s6e3fc3_6a_esd_check(ctx), (int)s6e3fc3_6a_ESD_STATUS);
+	s6e3fc3_6a_esd_recover(ctx, s6e3fc3_6a_ESD_STATUS);
+	s6e3fc3_6a_test_report(test, "esd reset", PANEL_REV_MP);
+	s6e3fc3_6a_test_expect_locked(test);
+	KUNIT_EXPECT_EQ(test, esd->restored, 1U);
+	KUNIT_EXPECT_EQ(test, esd->resets, 1U);
+	KUNIT_EXPECT_EQ(test, esd->failed, 0U);
+	KUNIT_EXPECT_EQ(test, t->model.sleep_ins, 1U);
+	KUNIT_EXPECT_TRUE(test, ctx->enabled);
+	KUNIT_EXPECT_TRUE(test, t->model.sleep_out);
+	KUNIT_EXPECT_TRUE(test, t->model.display_on);
+	KUNIT_EXPECT_EQ(test, (int)ctx->hbm_mode, (int)HBM_ON_IRC_OFF);
+	KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, MIPI_DCS_WRITE_CONTROL_DISPLAY, 0),
+			s6e3fc3_6a_WRCTRLD_BCTRL_BIT | s6e3fc3_6a_WRCTRLD_HBM_BIT);
+	KUNIT_EXPECT_EQ(test, s6e3fc3_6a_test_reg(t, 0x8F, 0x03), 0x05);
+
+	/* every tier fails, the panel is power cycled each time */
+	t->model.dead = true;
+	for (i = 0; i < s6e3fc3_6a_ESD_MAX_RETRIES; i++)
+		s6e3fc3_6a_esd_recover(ctx, s6e3fc3_6a_ESD_STATUS);
+	KUNIT_EXPECT_EQ(test, esd->restored, 1U);
+	KUNIT_EXPECT_EQ(test, esd->resets, 1U);
+	KUNIT_EXPECT_EQ(test, esd->failed, (u32)s6e3fc3_6a_ESD_MAX_RETRIES);
+	KUNIT_EXPECT_EQ(test, esd->retries, (u32)s6e3fc3_6a_ESD_MAX_RETRIES);
+	KUNIT_EXPECT_EQ(test, t->model.sleep_ins, (u32)(1 + s6e3fc3_6a_ESD_MAX_RETRIES));
+	KUNIT_EXPECT_FALSE(test, esd->busy);
+	KUNIT_EXPECT_EQ(test, esd->faults[s6e3fc3_6a_ESD_STATUS],
+			(u32)(1 + s6e3fc3_6a_ESD_MAX_RETRIES));
+}
+
+static const struct backlight_ops s6e3fc3_6a_test_bl_ops;
+
+/* the panel as s6e3fc3_6a_panel_probe() leaves it, enabled in its first mode */
+static int s6e3fc3_6a_test_init(struct kunit *test)
+{
+	const struct of_device_id *match = exynos_panel_driver.driver.of_match_table;
+	struct backlight_properties props = {
+		.type = BACKLIGHT_RAW,
+	};
+	struct s6e3fc3_6a_panel *spanel;
+	struct exynos_panel *ctx;
+	struct s6e3fc3_6a_test *t;
+
+	t = kunit_kzalloc(test, sizeof(*t), GFP_KERNEL);
+	if (!t)
+		return -ENOMEM;
+
+	spanel = &t->spanel;
+	ctx = &spanel->base;
+	INIT_WORK(&spanel->lhbm.latency_work, s6e3fc3_6a_lhbm_latency_work);
+	INIT_DELAYED_WORK(&spanel->lhbm.gamma_work, s6e3fc3_6a_lhbm_gamma_work);
+	INIT_DELAYED_WORK(&spanel->idle.work, s6e3fc3_6a_idle_work);
+	INIT_DELAYED_WORK(&spanel->aod.work, s6e3fc3_6a_aod_work);
+	INIT_WORK(&spanel->bl_transition.work, s6e3fc3_6a_bl_transition_work);
+	INIT_DELAYED_WORK(&spanel->state.flush_work, s6e3fc3_6a_state_flush_work);
+	INIT_DELAYED_WORK(&spanel->esd.work, s6e3fc3_6a_esd_work);
+	mutex_init(&spanel->notify.lock);
+	test->priv = t;
+
+	t->model.regs = vzalloc(256 * sizeof(*t->model.regs));
+	if (!t->model.regs)
+		return -ENOMEM;
+
+	t->host.ops = &s6e3fc3_6a_test_host_ops;
+	t->dsi.host = &t->host;
+	if (!kunit_alloc_resource(test, s6e3fc3_6a_test_dev_init, s6e3fc3_6a_test_dev_free,
+				  GFP_KERNEL, &t->dsi.dev))
+		return -ENOMEM;
+
+	spanel->state.enabled = true;
+	spanel->aod.bin = -1;
+	spanel->aod.hysteresis = s6e3fc3_6a_AOD_HYSTERESIS;
+	spanel->aod.min_dwell_ms = s6e3fc3_6a_AOD_MIN_DWELL_MS;
+	spanel->power_stats.since = ktime_get();
+
+	mutex_init(&ctx->mode_lock);
+	mutex_init(&ctx->bl_state_lock);
+	ctx->dev = &t->dsi.dev;
+	ctx->desc = match->data;
+	ctx->current_mode = &ctx->desc->modes[0];
+	drm_panel_init(&ctx->panel, ctx->dev, ctx->desc->panel_func, DRM_MODE_CONNECTOR_DSI);
+	/* no supplies are described for the mock device, these are dummies */
+	ctx->vci = devm_regulator_get(ctx->dev, "vci");
+	if (IS_ERR(ctx->vci))
+		return PTR_ERR(ctx->vci);
+	ctx->vddi = devm_regulator_get(ctx->dev, "vddi");
+	if (IS_ERR(ctx->vddi))
+		return PTR_ERR(ctx->vddi);
+	/* keeps exynos_panel_reset() from reading the panel id */
+	ctx->initialized = true;
+	ctx->enabled = true;
+
+	props.max_brightness = ctx->desc->max_brightness;
+	props.brightness = ctx->desc->dft_brightness;
+	ctx->bl = devm_backlight_device_register(ctx->dev, dev_name(ctx->dev), NULL, ctx,
+						 &s6e3fc3_6a_test_bl_ops, &props);
+	if (IS_ERR(ctx->bl))
+		return PTR_ERR(ctx->bl);
+
+	return 0;
+}
+
+static void s6e3fc3_6a_test_exit(struct kunit *test)
+{
+	struct s6e3fc3_6a_test *t = test->priv;
+
+	if (!t)
+		return;
+
+	cancel_work_sync(&t->spanel.lhbm.latency_work);
+	cancel_delayed_work_sync(&t->spanel.lhbm.gamma_work);
+	cancel_delayed_work_sync(&t->spanel.idle.work);
+	cancel_delayed_work_sync(&t->spanel.aod.work);
+	cancel_work_sync(&t->spanel.bl_transition.work);
+	cancel_delayed_work_sync(&t->spanel.state.flush_work);
+	cancel_delayed_work_sync(&t->spanel.esd.work);
+	vfree(t->model.regs);
+}
+
+static struct kunit_case s6e3fc3_6a_test_cases[] = {
+	KUNIT_CASE(s6e3fc3_6a_test_init_cmd_set),
+	KUNIT_CASE(s6e3fc3_6a_test_pwm_cmd_sets),
+	KUNIT_CASE(s6e3fc3_6a_test_change_frequency),
+	KUNIT_CASE(s6e3fc3_6a_test_pps),
+	KUNIT_CASE(s6e3fc3_6a_test_enable),
+	KUNIT_CASE(s6e3fc3_6a_test_lp_mode),
+	KUNIT_CASE(s6e3fc3_6a_test_hbm_irc),
+	KUNIT_CASE(s6e3fc3_6a_test_local_hbm),
+	KUNIT_CASE(s6e3fc3_6a_test_te2_setting),
+	KUNIT_CASE(s6e3fc3_6a_test_te2),
+	KUNIT_CASE(s6e3fc3_6a_test_notifier),
+	KUNIT_CASE(s6e3fc3_6a_test_batched_cmd_sets),
+	KUNIT_CASE(s6e3fc3_6a_test_replay_enable_hbm),
+	KUNIT_CASE(s6e3fc3_6a_test_esd),
+	{}
+};
+
+static struct kunit_suite s6e3fc3_6a_test_suite = {
+	.name = "panel-samsung-s6e3fc3_6a",
+	.init = s6e3fc3_6a_test_init,
+	.exit = s6e3fc3_6a_test_exit,
+	.test_cases = s6e3fc3_6a_test_cases,
+};
+kunit_test_suite(s6e3fc3_6a_test_suite);
+
+MODULE_DESCRIPTION("KUnit tests for the Samsung s6e3fc3_6a panel driver");
+MODULE_LICENSE("GPL");
@@ -0,0 +1,97 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Tracepoints for the s6e3fc3_6a panel driver.
+ *
+ * Copyright 2021 Google LLC
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM panel_s6e3fc3_6a
+
+#if !defined(_PANEL_SAMSUNG_S6E3FC3_6A_TRACE_H_) || defined(TRACE_HEADER_MULTI_READ)
+#define _PANEL_SAMSUNG_S6E3FC3_6A_TRACE_H_
+
+#include <linux/tracepoint.h>
+
+TRACE_EVENT(s6e3fc3_6a_dcs_write,
+	TP_PROTO(u8 opcode, size_t len, bool queued, u32 duration_ns),
+	TP_ARGS(opcode, len, queued, duration_ns),
+	TP_STRUCT__entry(
+		__field(u8, opcode)
+		__field(size_t, len)
+		__field(bool, queued)
+		__field(u32, duration_ns)
+	),
+	TP_fast_assign(
+		__entry->opcode = opcode;
+		__entry->len = len;
+		__entry->queued = queued;
+		__entry->duration_ns = duration_ns;
+	),
+	TP_printk("opcode=0x%02x len=%zu queued=%d duration_ns=%u",
+		  __entry->opcode, __entry->len, __entry->queued,
+		  __entry->duration_ns)
+);
+
+TRACE_EVENT(s6e3fc3_6a_dcs_read,
+	TP_PROTO(u8 opcode, size_t len, int ret, u32 duration_ns),
+	TP_ARGS(opcode, len, ret, duration_ns),
+	TP_STRUCT__entry(
+		__field(u8, opcode)
+		__field(size_t, len)
+		__field(int, ret)
+		__field(u32, duration_ns)
+	),
+	TP_fast_assign(
+		__entry->opcode = opcode;
+		__entry->len = len;
+		__entry->ret = ret;
+		__entry->duration_ns = duration_ns;
+	),
+	TP_printk("opcode=0x%02x len=%zu ret=%d duration_ns=%u",
+		  __entry->opcode, __entry->len, __entry->ret,
+		  __entry->duration_ns)
+);
+
+TRACE_EVENT(s6e3fc3_6a_cmd_set,
+	TP_PROTO(u8 opcode, u32 num_cmd, u32 len, u32 duration_ns),
+	TP_ARGS(opcode, num_cmd, len, duration_ns),
+	TP_STRUCT__entry(
+		__field(u8, opcode)
+		__field(u32, num_cmd)
+		__field(u32, len)
+		__field(u32, duration_ns)
+	),
+	TP_fast_assign(
+		__entry->opcode = opcode;
+		__entry->num_cmd = num_cmd;
+		__entry->len = len;
+		__entry->duration_ns = duration_ns;
+	),
+	TP_printk("first_opcode=0x%02x num_cmd=%u len=%u duration_ns=%u",
+		  __entry->opcode, __entry->num_cmd, __entry->len,
+		  __entry->duration_ns)
+);
+
+TRACE_EVENT(s6e3fc3_6a_op,
+	TP_PROTO(const char *name, u32 duration_us),
+	TP_ARGS(name, duration_us),
+	TP_STRUCT__entry(
+		__string(name, name)
+		__field(u32, duration_us)
+	),
+	TP_fast_assign(
+		__assign_str(name, name);
+		__entry->duration_us = duration_us;
+	),
+	TP_printk("%s duration_us=%u", __get_str(name), __entry->duration_us)
+);
+
+#endif /* _PANEL_SAMSUNG_S6E3FC3_6A_TRACE_H_ */
+
+/* This part must be outside protection */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE panel-samsung-s6e3fc3_6a-trace
+#include <trace/define_trace.h>
@@ -9,13 +9,41 @@
  * published by the Free Software Foundation.
  */
 
+#include <drm/drm_dsc.h>
+#include <drm/drm_encoder.h>
 #include <drm/drm_vblank.h>
+#include <linux/backlight.h>
+#include <linux/debugfs.h>
+#include <linux/log2.h>
 #include <linux/module.h>
 #include <linux/of_platform.h>
+#include <linux/seq_file.h>
+#include <linux/thermal.h>
+#include <linux/workqueue.h>
 #include <video/mipi_display.h>
 
 #include "samsung/panel/panel-samsung-drv.h"
 
+#include "panel-samsung-s6e3fc3_6a.h"
+
+/* the KUnit module builds this file too and traces through the driver's tracepoints */
+#ifndef s6e3fc3_6a_KUNIT_TEST
+#define CREATE_TRACE_POINTS
+#endif
+#include "panel-samsung-s6e3fc3_6a-trace.h"
+
+#ifndef s6e3fc3_6a_KUNIT_TEST
+EXPORT_TRACEPOINT_SYMBOL_GPL(s6e3fc3_6a_dcs_write);
+EXPORT_TRACEPOINT_SYMBOL_GPL(s6e3fc3_6a_dcs_read);
+EXPORT_TRACEPOINT_SYMBOL_GPL(s6e3fc3_6a_cmd_set);
+EXPORT_TRACEPOINT_SYMBOL_GPL(s6e3fc3_6a_op);
+#endif
+
+/*
+ * Vendor PPS for 1080x2400 with two 540x48 slices. The driver generates the
+ * PPS of each mode from its DSC settings, this table is only kept as the
+ * reference the generated PPS is checked against at probe.
+ */
 static const unsigned char PPS_SETTING[] = {
 	0x11, 0x00, 0x00, 0x89, 0x30, 0x80, 0x09, 0x60,
 	0x04, 0x38, 0x00, 0x30, 0x02, 0x1C, 0x02, 0x1C,
@@ -40,6 +68,612 @@ static const unsigned char PPS_SETTING[] = {
 #define s6e3fc3_6a_WRCTRLD_HBM_BIT        0xC0
 #define s6e3fc3_6a_WRCTRLD_LOCAL_HBM_BIT  0x10
 
+#define s6e3fc3_6a_SHADOW_WRCTRLD  BIT(0)
+#define s6e3fc3_6a_SHADOW_FREQ     BIT(1)
+#define s6e3fc3_6a_SHADOW_IRC      BIT(2)
+/* one bit per s6e3fc3_6a_te2_regs entry */
+#define s6e3fc3_6a_SHADOW_TE2(i)   BIT(3 + (i))
+
+/**
+ * enum s6e3fc3_6a_enable_stage - steps of s6e3fc3_6a_enable(), in vendor order
+ *
+ * Nothing is sent to the panel between sleep out and the end of its delay.
+ */
+enum s6e3fc3_6a_enable_stage {
+	s6e3fc3_6a_STAGE_RESET,
+	s6e3fc3_6a_STAGE_SLEEP_OUT,
+	s6e3fc3_6a_STAGE_SLEEP_OUT_DONE,
+	s6e3fc3_6a_STAGE_INIT,
+	s6e3fc3_6a_STAGE_FREQ,
+	s6e3fc3_6a_STAGE_LHBM_GAMMA,
+	s6e3fc3_6a_STAGE_PPS,
+	s6e3fc3_6a_STAGE_WRCTRLD,
+	s6e3fc3_6a_STAGE_DISPLAY_ON,
+	s6e3fc3_6a_STAGE_MAX,
+};
+
+static const char * const s6e3fc3_6a_enable_stage_names[s6e3fc3_6a_STAGE_MAX] = {
+	[s6e3fc3_6a_STAGE_RESET] = "reset",
+	[s6e3fc3_6a_STAGE_SLEEP_OUT] = "sleep_out",
+	[s6e3fc3_6a_STAGE_SLEEP_OUT_DONE] = "sleep_out_done",
+	[s6e3fc3_6a_STAGE_INIT] = "init",
+	[s6e3fc3_6a_STAGE_FREQ] = "freq",
+	[s6e3fc3_6a_STAGE_LHBM_GAMMA] = "lhbm_gamma",
+	[s6e3fc3_6a_STAGE_PPS] = "pps",
+	[s6e3fc3_6a_STAGE_WRCTRLD] = "wrctrld",
+	[s6e3fc3_6a_STAGE_DISPLAY_ON] = "display_on",
+};
+
+/* bucket 0 counts 0us, bucket n counts [2^(n-1), 2^n) us, the last one is open ended */
+#define s6e3fc3_6a_HIST_BUCKETS 20
+
+/**
+ * struct s6e3fc3_6a_hist - log2 latency histogram
+ */
+struct s6e3fc3_6a_hist {
+	/** @bucket: number of samples in each log2 bucket */
+	u32 bucket[s6e3fc3_6a_HIST_BUCKETS];
+	/** @count: total number of samples */
+	u32 count;
+	/** @max_us: largest sample */
+	u32 max_us;
+	/** @sum_us: sum of all samples */
+	u64 sum_us;
+};
+
+/* commands sent closer than this to the next TE may slip by a frame */
+#define s6e3fc3_6a_TE_GUARD_US 1000
+
+#define s6e3fc3_6a_LOCAL_HBM_GAMMA_CMD_SIZE 6
+/* time userspace has to restore a saved LHBM gamma before it is read back */
+#define s6e3fc3_6a_LHBM_GAMMA_WAIT_MS 5000
+
+/**
+ * struct s6e3fc3_6a_lhbm - local HBM activation tracking
+ */
+struct s6e3fc3_6a_lhbm {
+	/** @latency_work: waits for the TE and first frame after an activation */
+	struct work_struct latency_work;
+	/** @request_ts: time local HBM was requested */
+	ktime_t request_ts;
+	/** @sent_vblank: vblank count when the command was sent */
+	u64 sent_vblank;
+	/** @to_te: latency from request to the TE latching the command */
+	struct s6e3fc3_6a_hist to_te;
+	/** @to_frame: latency from request to the first frame with local HBM on */
+	struct s6e3fc3_6a_hist to_frame;
+	/**
+	 * @gamma_work: reads back the LHBM gamma if userspace did not restore it
+	 * within s6e3fc3_6a_LHBM_GAMMA_WAIT_MS of the panel init
+	 */
+	struct delayed_work gamma_work;
+	/** @gamma_pending: @gamma_work is to be queued on the next commit */
+	bool gamma_pending;
+	/** @gamma_init: panel id is known, lhbm_gamma can be checked against it */
+	bool gamma_init;
+	/** @gamma_saved: lhbm_gamma written before @gamma_init */
+	char gamma_saved[64];
+	/** @gamma_source: where the LHBM gamma in use came from */
+	const char *gamma_source;
+	/** @gamma_read_us: time the gamma readback took, 0 if it was not read */
+	u32 gamma_read_us;
+};
+
+/**
+ * enum s6e3fc3_6a_op - operations with an always-on latency histogram
+ */
+enum s6e3fc3_6a_op {
+	s6e3fc3_6a_OP_DCS_WRITE,
+	s6e3fc3_6a_OP_DCS_READ,
+	s6e3fc3_6a_OP_CMD_SET,
+	s6e3fc3_6a_OP_TE2,
+	s6e3fc3_6a_OP_FREQ,
+	s6e3fc3_6a_OP_HBM,
+	s6e3fc3_6a_OP_LHBM_GAMMA_READ,
+	s6e3fc3_6a_OP_NOLP,
+	s6e3fc3_6a_OP_ENABLE,
+	s6e3fc3_6a_OP_BRIGHTNESS,
+	s6e3fc3_6a_OP_ESD_RESTORE,
+	s6e3fc3_6a_OP_ESD_RESET,
+	s6e3fc3_6a_OP_MAX,
+};
+
+static const char * const s6e3fc3_6a_op_names[s6e3fc3_6a_OP_MAX] = {
+	[s6e3fc3_6a_OP_DCS_WRITE] = "dcs_write",
+	[s6e3fc3_6a_OP_DCS_READ] = "dcs_read",
+	[s6e3fc3_6a_OP_CMD_SET] = "cmd_set",
+	[s6e3fc3_6a_OP_TE2] = "update_te2",
+	[s6e3fc3_6a_OP_FREQ] = "change_frequency",
+	[s6e3fc3_6a_OP_HBM] = "set_hbm_mode",
+	[s6e3fc3_6a_OP_LHBM_GAMMA_READ] = "lhbm_gamma_read",
+	[s6e3fc3_6a_OP_NOLP] = "set_nolp_mode",
+	[s6e3fc3_6a_OP_ENABLE] = "enable",
+	[s6e3fc3_6a_OP_BRIGHTNESS] = "set_brightness",
+	[s6e3fc3_6a_OP_ESD_RESTORE] = "esd_restore",
+	[s6e3fc3_6a_OP_ESD_RESET] = "esd_reset",
+};
+
+/* refresh rate used while content is static */
+#define s6e3fc3_6a_IDLE_VREFRESH 60
+
+/**
+ * struct s6e3fc3_6a_idle - refresh rate downshift while content is static
+ */
+struct s6e3fc3_6a_idle {
+	/** @work: lowers the refresh rate once nothing was committed for @frames frames */
+	struct delayed_work work;
+	/** @frames: frames without a commit before downshifting, 0 disables it */
+	u32 frames;
+	/** @vrefresh: refresh rate of the current mode */
+	u32 vrefresh;
+	/** @active: panel runs at s6e3fc3_6a_IDLE_VREFRESH instead of @vrefresh */
+	bool active;
+	/** @count: number of downshifts */
+	u32 count;
+	/** @wakeup: latency from the first new frame to running at @vrefresh again */
+	struct s6e3fc3_6a_hist wakeup;
+};
+
+/**
+ * struct s6e3fc3_6a_freq_stats - time the panel spent at each refresh rate
+ */
+struct s6e3fc3_6a_freq_stats {
+	/** @vrefresh: refresh rate the panel runs at, 0 when off or in LP mode */
+	u32 vrefresh;
+	/** @since: time the panel switched to @vrefresh */
+	ktime_t since;
+	/** @ms_60hz: time spent at 60Hz */
+	u64 ms_60hz;
+	/** @ms_90hz: time spent at 90Hz */
+	u64 ms_90hz;
+};
+
+/* TE histograms use linear buckets, the last one is open ended */
+#define s6e3fc3_6a_TE_BUCKET_US  100
+#define s6e3fc3_6a_TE_BUCKETS    64
+#define s6e3fc3_6a_TE_MODES_MAX  4
+
+/**
+ * struct s6e3fc3_6a_te_hist - linear histogram of TE relative timings
+ */
+struct s6e3fc3_6a_te_hist {
+	/** @bucket: number of samples in each s6e3fc3_6a_TE_BUCKET_US bucket */
+	u32 bucket[s6e3fc3_6a_TE_BUCKETS];
+	/** @count: total number of samples */
+	u32 count;
+	/** @max_us: largest sample */
+	u32 max_us;
+};
+
+/**
+ * struct s6e3fc3_6a_te_mode_stats - TE timing of the frames of one mode
+ *
+ * TE timestamps come from the vblank the DPU records for every TE, they are
+ * sampled when a commit is done.
+ */
+struct s6e3fc3_6a_te_mode_stats {
+	/** @pmode: mode the stats belong to, NULL for an unused slot */
+	const struct exynos_panel_mode *pmode;
+	/** @jitter: difference between a TE-to-TE interval and the mode period */
+	struct s6e3fc3_6a_te_hist jitter;
+	/** @slack: time left until the next TE when a commit is done */
+	struct s6e3fc3_6a_te_hist slack;
+	/** @frames: number of commits sampled */
+	u32 frames;
+	/** @missed: TEs without a new frame while commits were back to back */
+	u32 missed;
+	/** @late: commits done with less than te_idle_us left before the next TE */
+	u32 late;
+};
+
+/**
+ * struct s6e3fc3_6a_te_stats - per-mode TE timing telemetry
+ */
+struct s6e3fc3_6a_te_stats {
+	/** @mode: stats of each mode seen so far */
+	struct s6e3fc3_6a_te_mode_stats mode[s6e3fc3_6a_TE_MODES_MAX];
+	/** @last_pmode: mode of the last sample, NULL after disable */
+	const struct exynos_panel_mode *last_pmode;
+	/** @last_period_us: TE period at the last sample */
+	u32 last_period_us;
+	/** @last_count: vblank count at the last sample */
+	u64 last_count;
+	/** @last_te: vblank time at the last sample */
+	ktime_t last_te;
+	/** @last_done: time the last sampled commit was done */
+	ktime_t last_done;
+};
+
+/**
+ * enum s6e3fc3_6a_power_state - panel states tracked for power profiling
+ *
+ * The LP states follow the order of s6e3fc3_6a_binned_lp, s6e3fc3_6a_PS_LP is
+ * used while the LP bin is not known yet.
+ */
+enum s6e3fc3_6a_power_state {
+	s6e3fc3_6a_PS_OFF,
+	s6e3fc3_6a_PS_60HZ,
+	s6e3fc3_6a_PS_90HZ,
+	s6e3fc3_6a_PS_HBM,
+	s6e3fc3_6a_PS_HBM_IRC_OFF,
+	s6e3fc3_6a_PS_LHBM,
+	s6e3fc3_6a_PS_LP,
+	s6e3fc3_6a_PS_LP_OFF,
+	s6e3fc3_6a_PS_LP_LOW,
+	s6e3fc3_6a_PS_LP_HIGH,
+	s6e3fc3_6a_PS_MAX,
+};
+
+static const char * const s6e3fc3_6a_power_state_names[s6e3fc3_6a_PS_MAX] = {
+	[s6e3fc3_6a_PS_OFF] = "off",
+	[s6e3fc3_6a_PS_60HZ] = "60hz",
+	[s6e3fc3_6a_PS_90HZ] = "90hz",
+	[s6e3fc3_6a_PS_HBM] = "hbm",
+	[s6e3fc3_6a_PS_HBM_IRC_OFF] = "hbm_irc_off",
+	[s6e3fc3_6a_PS_LHBM] = "lhbm",
+	[s6e3fc3_6a_PS_LP] = "lp",
+	[s6e3fc3_6a_PS_LP_OFF] = "lp_off",
+	[s6e3fc3_6a_PS_LP_LOW] = "lp_low",
+	[s6e3fc3_6a_PS_LP_HIGH] = "lp_high",
+};
+
+/**
+ * struct s6e3fc3_6a_power_stats - residency and transitions of each power state
+ */
+struct s6e3fc3_6a_power_stats {
+	/** @state: current state */
+	enum s6e3fc3_6a_power_state state;
+	/** @since: time @state was entered */
+	ktime_t since;
+	/** @ms: time spent in each state, not counting the current period */
+	u64 ms[s6e3fc3_6a_PS_MAX];
+	/** @transitions: number of moves from the first to the second state */
+	u32 transitions[s6e3fc3_6a_PS_MAX][s6e3fc3_6a_PS_MAX];
+	/** @dimming_since: time dimming was turned on, 0 when off */
+	ktime_t dimming_since;
+	/** @dimming_ms: time spent with dimming on, not counting the current period */
+	u64 dimming_ms;
+	/** @updates: number of state evaluations */
+	u32 updates;
+	/** @update_ns: total time spent evaluating the state */
+	u64 update_ns;
+};
+
+/**
+ * enum s6e3fc3_6a_thermal_state - cooling states, each one includes the previous
+ */
+enum s6e3fc3_6a_thermal_state {
+	s6e3fc3_6a_THERMAL_NONE,
+	/* HBM brightness is capped at s6e3fc3_6a_THERMAL_HBM_CAP */
+	s6e3fc3_6a_THERMAL_HBM_CAP_STATE,
+	/* HBM is turned off and brightness is capped at the normal range */
+	s6e3fc3_6a_THERMAL_NO_HBM,
+	/* refresh rate is capped at 60Hz */
+	s6e3fc3_6a_THERMAL_60HZ,
+	s6e3fc3_6a_THERMAL_MAX = s6e3fc3_6a_THERMAL_60HZ,
+};
+
+#define s6e3fc3_6a_THERMAL_HBM_CAP 3071
+
+/**
+ * struct s6e3fc3_6a_thermal - display cooling device
+ */
+struct s6e3fc3_6a_thermal {
+	/** @cdev: cooling device bound to the display thermal zone */
+	struct thermal_cooling_device *cdev;
+	/** @state: current s6e3fc3_6a_thermal_state */
+	unsigned long state;
+	/** @hbm_req: HBM mode last requested, applied once @state allows it */
+	enum exynos_hbm_mode hbm_req;
+};
+
+/**
+ * struct s6e3fc3_6a_io_stats - DSI traffic and sleeps of the panel callbacks
+ *
+ * Counters only ever grow until reset, a workload replay reads them before and
+ * after a scenario and uses the difference.
+ */
+struct s6e3fc3_6a_io_stats {
+	/** @tx_count: DSI write transfers */
+	u32 tx_count;
+	/** @tx_bytes: DSI write payload bytes */
+	u64 tx_bytes;
+	/** @rx_count: DSI read transfers */
+	u32 rx_count;
+	/** @rx_bytes: DSI read payload bytes */
+	u64 rx_bytes;
+	/** @sleeps: sleeps taken in panel callbacks */
+	u32 sleeps;
+	/** @sleep_us: time spent sleeping in panel callbacks */
+	u64 sleep_us;
+	/** @tx_errors: DSI write transfers that failed */
+	u32 tx_errors;
+	/** @rx_errors: DSI read transfers that failed */
+	u32 rx_errors;
+};
+
+#define s6e3fc3_6a_STATE_PWM      BIT(0)
+#define s6e3fc3_6a_STATE_IRC      BIT(1)
+#define s6e3fc3_6a_STATE_WRCTRLD  BIT(2)
+#define s6e3fc3_6a_STATE_FREQ     BIT(3)
+#define s6e3fc3_6a_STATE_BRIGHTNESS BIT(4)
+
+/**
+ * struct s6e3fc3_6a_state - panel state changes waiting for the end of a commit
+ *
+ * HBM, dimming, brightness and refresh rate callbacks of a commit only record
+ * what they changed, commit_done then queues @flush_work to send everything as
+ * one burst, the TE guard sleeps so it cannot run on the commit path itself.
+ */
+struct s6e3fc3_6a_state {
+	/** @enabled: defer changes to commit_done instead of writing them right away */
+	bool enabled;
+	/** @pending: bitmask of s6e3fc3_6a_STATE_* waiting to be sent */
+	u32 pending;
+	/** @vrefresh: refresh rate to program with s6e3fc3_6a_STATE_FREQ */
+	u32 vrefresh;
+	/** @brightness: level to program with s6e3fc3_6a_STATE_BRIGHTNESS */
+	u16 brightness;
+	/** @flush_work: sends pending changes after commit_done, or if none follows */
+	struct delayed_work flush_work;
+	/** @transfers: DSI transfers of each flush */
+	struct s6e3fc3_6a_hist transfers;
+	/** @spilled: flushes that went past the TE they were aimed at */
+	u32 spilled;
+};
+
+/**
+ * struct s6e3fc3_6a_notify - display state published to peer drivers
+ */
+struct s6e3fc3_6a_notify {
+	/**
+	 * @lock: serializes events, not every caller holds mode_lock, e.g.
+	 * disable and update_te2
+	 */
+	struct mutex lock;
+	/** @last: state sent with the last event */
+	struct s6e3fc3_6a_notify_data last;
+	/** @events: events sent */
+	u32 events;
+	/** @hist: time spent in the notifier chain for each event, in us */
+	struct s6e3fc3_6a_hist hist;
+};
+
+/* TE periods the health check waits for a TE */
+#define s6e3fc3_6a_ESD_TE_PERIODS 3
+/* failed recoveries in a row before the watchdog gives up until the next enable */
+#define s6e3fc3_6a_ESD_MAX_RETRIES 3
+/* power mode bits checked against the state the driver left the panel in */
+#define s6e3fc3_6a_ESD_POWER_MODE \
+	(MIPI_DCS_POWER_MODE_SLEEP_MODE | MIPI_DCS_POWER_MODE_DISPLAY)
+
+enum s6e3fc3_6a_esd_fault {
+	s6e3fc3_6a_ESD_NONE,
+	s6e3fc3_6a_ESD_TX_ERROR,
+	s6e3fc3_6a_ESD_READ_ERROR,
+	s6e3fc3_6a_ESD_STATUS,
+	s6e3fc3_6a_ESD_TE_LOST,
+	s6e3fc3_6a_ESD_FAULT_MAX,
+};
+
+static const char * const s6e3fc3_6a_esd_fault_names[s6e3fc3_6a_ESD_FAULT_MAX] = {
+	[s6e3fc3_6a_ESD_NONE] = "none",
+	[s6e3fc3_6a_ESD_TX_ERROR] = "tx_error",
+	[s6e3fc3_6a_ESD_READ_ERROR] = "read_error",
+	[s6e3fc3_6a_ESD_STATUS] = "status",
+	[s6e3fc3_6a_ESD_TE_LOST] = "te_lost",
+};
+
+/**
+ * struct s6e3fc3_6a_esd - panel watchdog and tiered recovery
+ *
+ * A failed check first re-sends the state the driver has cached for the
+ * panel, only if the panel is still faulty afterwards is it reset and fully
+ * initialized again.
+ */
+struct s6e3fc3_6a_esd {
+	/** @work: periodic health check */
+	struct delayed_work work;
+	/**
+	 * @period_ms: interval between checks, 0 (default) disables the watchdog,
+	 * set through debugfs esd_period_ms
+	 */
+	u32 period_ms;
+	/** @busy: recovery in progress, its own DSI errors do not kick the check */
+	bool busy;
+	/** @retries: recoveries in a row that left the panel faulty */
+	u32 retries;
+	/** @tx_errors: io_stats.tx_errors when last checked */
+	u32 tx_errors;
+	/** @inject: fault reported by the next check instead of probing the panel */
+	enum s6e3fc3_6a_esd_fault inject;
+	/** @faults: faults detected, by type */
+	u32 faults[s6e3fc3_6a_ESD_FAULT_MAX];
+	/** @restored: faults cleared by re-sending the cached state */
+	u32 restored;
+	/** @resets: faults cleared by a reset */
+	u32 resets;
+	/** @failed: recoveries that left the panel faulty */
+	u32 failed;
+};
+
+/* progress of a brightness transition is computed in 1/1024 steps */
+#define s6e3fc3_6a_BL_TRANSITION_ONE 1024
+
+enum s6e3fc3_6a_bl_curve {
+	s6e3fc3_6a_BL_CURVE_LINEAR,
+	s6e3fc3_6a_BL_CURVE_EASE,
+};
+
+/**
+ * struct s6e3fc3_6a_bl_transition - brightness ramp paced by TE
+ *
+ * Ramps are interpolated in nits and converted back to brightness levels
+ * through @lut, one brightness write per TE at most.
+ */
+struct s6e3fc3_6a_bl_transition {
+	/** @work: runs the ramp, one step per vblank */
+	struct work_struct work;
+	/** @lut: brightness level to millinits, built from the brightness capability */
+	u32 *lut;
+	/** @lut_len: number of entries in @lut */
+	u32 lut_len;
+	/** @from: brightness level the ramp started from */
+	u16 from;
+	/** @target: brightness level at the end of the ramp */
+	u16 target;
+	/**
+	 * @level: level last written by the ramp, kept out of the backlight
+	 * device until the ramp reaches @target
+	 */
+	u16 level;
+	/** @active: a ramp is running */
+	bool active;
+	/** @duration_ms: length of the ramp */
+	u32 duration_ms;
+	/** @curve: interpolation of the ramp in nits */
+	enum s6e3fc3_6a_bl_curve curve;
+	/** @start: time the ramp started */
+	ktime_t start;
+	/** @steps: frames the last ramp ran for */
+	u32 steps;
+	/** @writes: brightness writes the last ramp needed */
+	u32 writes;
+};
+
+/**
+ * struct s6e3fc3_6a_aod - binned LP state with hysteresis
+ *
+ * A bin change towards a brighter bin needs the brightness to exceed the
+ * current bin threshold by @hysteresis, a change towards a dimmer bin needs it
+ * to be @hysteresis below the new bin threshold. Neither happens before
+ * @min_dwell_ms in the current bin, @work checks the brightness again once
+ * the dwell time is over. Entering or leaving the "off" bin is never delayed.
+ */
+struct s6e3fc3_6a_aod {
+	/** @bin: index of the current binned LP mode, -1 when unknown */
+	int bin;
+	/** @since: time the current bin was entered */
+	ktime_t since;
+	/** @hysteresis: brightness levels of hysteresis around bin thresholds */
+	u32 hysteresis;
+	/** @min_dwell_ms: minimum time spent in a bin before changing it */
+	u32 min_dwell_ms;
+	/** @lp_start: time LP mode was entered, 0 when not in LP mode */
+	ktime_t lp_start;
+	/** @lp_ms: time spent in LP mode, not counting the current period */
+	u64 lp_ms;
+	/** @work: applies @brightness once the dwell time of the current bin is over */
+	struct delayed_work work;
+	/** @brightness: last brightness requested in LP mode */
+	u16 brightness;
+	/** @transitions: bin changes sent to the panel */
+	u32 transitions;
+	/** @suppressed: bin changes held back by hysteresis or dwell time */
+	u32 suppressed;
+};
+
+#define s6e3fc3_6a_AOD_HYSTERESIS      8
+#define s6e3fc3_6a_AOD_MIN_DWELL_MS    2000
+
+#define s6e3fc3_6a_TE2_MAX         8
+#define s6e3fc3_6a_TE2_SETTING_LEN 3
+/* delay and width are 12-bit fields of the TE2 setting */
+#define s6e3fc3_6a_TE2_EDGE_MAX    0xFFF
+
+/**
+ * struct s6e3fc3_6a_shadow - cached state of the registers owned by the driver
+ *
+ * Registers behind a 0xB0 global parameter offset are cached per (register,
+ * offset) pair, so a write that hits the cache also drops its 0xB0 write.
+ */
+struct s6e3fc3_6a_shadow {
+	/** @valid: bitmask of s6e3fc3_6a_SHADOW_* entries holding panel state */
+	u32 valid;
+	/** @wrctrld: MIPI_DCS_WRITE_CONTROL_DISPLAY (0x53) */
+	u8 wrctrld;
+	/** @freq: frequency setting 0x60 */
+	u8 freq;
+	/** @irc: IRC setting 0x8F at global parameter offset 0x03 */
+	u8 irc;
+	/** @te2: TE2 0xCB setting of each s6e3fc3_6a_te2_regs entry */
+	u8 te2[s6e3fc3_6a_TE2_MAX][s6e3fc3_6a_TE2_SETTING_LEN];
+	/** @hit: number of writes dropped because the panel already had the value */
+	u32 hit;
+	/** @miss: number of writes sent to the panel */
+	u32 miss;
+};
+
+/**
+ * struct s6e3fc3_6a_pps - DSC picture parameter set generated for a mode
+ */
+struct s6e3fc3_6a_pps {
+	/** @pmode: mode this PPS belongs to */
+	const struct exynos_panel_mode *pmode;
+	/** @pps: packed PPS as sent to the panel */
+	struct drm_dsc_picture_parameter_set pps;
+	/** @chunk_size: bytes per slice per line */
+	u32 chunk_size;
+};
+
+/**
+ * struct s6e3fc3_6a_panel - panel specific runtime info
+ *
+ * This struct maintains s6e3fc3_6a panel specific runtime info, any fixed details
+ * about panel should most likely go into struct exynos_panel_desc
+ */
+struct s6e3fc3_6a_panel {
+	/** @base: base panel struct */
+	struct exynos_panel base;
+	/** @shadow: cached register state, see struct s6e3fc3_6a_shadow */
+	struct s6e3fc3_6a_shadow shadow;
+	/** @pps: PPS of each normal mode followed by the LP mode */
+	struct s6e3fc3_6a_pps *pps;
+	/** @num_pps: number of entries in @pps */
+	int num_pps;
+	/**
+	 * @lp_exit_blocking: exit LP mode with display off and a one frame wait
+	 * instead of letting the panel latch the new state on the next TE
+	 */
+	bool lp_exit_blocking;
+	/** @lp_exit_last_us: time spent in the last LP exit */
+	u32 lp_exit_last_us;
+	/** @lp_exit_max_us: longest LP exit seen so far */
+	u32 lp_exit_max_us;
+	/** @lhbm: local HBM activation tracking */
+	struct s6e3fc3_6a_lhbm lhbm;
+	/** @op_hist: latency histogram of each s6e3fc3_6a_op */
+	struct s6e3fc3_6a_hist op_hist[s6e3fc3_6a_OP_MAX];
+	/** @idle: refresh rate downshift while content is static */
+	struct s6e3fc3_6a_idle idle;
+	/** @freq_stats: refresh rate residency */
+	struct s6e3fc3_6a_freq_stats freq_stats;
+	/** @bl_transition: in-kernel brightness ramp */
+	struct s6e3fc3_6a_bl_transition bl_transition;
+	/** @aod: binned LP state */
+	struct s6e3fc3_6a_aod aod;
+	/** @te_stats: TE timing telemetry */
+	struct s6e3fc3_6a_te_stats te_stats;
+	/** @power_stats: power state residency */
+	struct s6e3fc3_6a_power_stats power_stats;
+	/** @thermal: display cooling device */
+	struct s6e3fc3_6a_thermal thermal;
+	/** @io_stats: DSI traffic and sleeps */
+	struct s6e3fc3_6a_io_stats io_stats;
+	/** @state: changes waiting for the end of the commit */
+	struct s6e3fc3_6a_state state;
+	/** @notify: state published through the notifier chain */
+	struct s6e3fc3_6a_notify notify;
+	/** @esd: panel watchdog */
+	struct s6e3fc3_6a_esd esd;
+	/** @enable_start: time s6e3fc3_6a_enable() was entered */
+	ktime_t enable_start;
+	/** @enable_stage_us: time from @enable_start to the end of each enable stage */
+	u32 enable_stage_us[s6e3fc3_6a_STAGE_MAX];
+};
+
+#define to_spanel(ctx) container_of(ctx, struct s6e3fc3_6a_panel, base)
+
 static const u8 display_off[] = { 0x28 };
 static const u8 display_on[] = { 0x29 };
 static const u8 test_key_on_f0[] = { 0xF0, 0x5A, 0x5A };
@@ -109,341 +743,2854 @@ static const struct exynos_dsi_cmd s6e3fc3_6a_4_pwm_cmds[] = {
 	EXYNOS_DSI_CMD0(freq_update),
 	EXYNOS_DSI_CMD0(test_key_off_f0)
 };
-static DEFINE_EXYNOS_CMD_SET(s6e3fc3_6a_4_pwm);
+static DEFINE_EXYNOS_CMD_SET(s6e3fc3_6a_4_pwm);
+
+static const struct exynos_binned_lp s6e3fc3_6a_binned_lp[] = {
+	BINNED_LP_MODE("off", 0, s6e3fc3_6a_lp_off_cmds),
+	/* rising time = delay = 0, falling time = delay + width = 0 + 16 */
+	BINNED_LP_MODE_TIMING("low", 80, s6e3fc3_6a_lp_low_cmds, 0, 0 + 16),
+	BINNED_LP_MODE_TIMING("high", 2047, s6e3fc3_6a_lp_high_cmds, 0, 0 + 16)
+};
+
+#define s6e3fc3_6a_SLEEP_OUT_DELAY_MS 120
+
+/* sleep out is sent separately by s6e3fc3_6a_enable(), see s6e3fc3_6a_enable_stage */
+static const struct exynos_dsi_cmd s6e3fc3_6a_init_cmds[] = {
+	EXYNOS_DSI_CMD_SEQ(0x35), /* TE on */
+	EXYNOS_DSI_CMD_SEQ(0x2A, 0x00, 0x00, 0x04, 0x37), /* CASET */
+	EXYNOS_DSI_CMD_SEQ(0x2B, 0x00, 0x00, 0x09, 0x5F), /* PASET */
+
+	EXYNOS_DSI_CMD0(test_key_on_f0),
+
+	/* TE rising time */
+	EXYNOS_DSI_CMD_SEQ_REV(PANEL_REV_LT(PANEL_REV_EVT1),
+			       0xB9, 0x01, 0x09, 0x5C, 0x00, 0x0B),
+
+	/* FQ CON setting */
+	EXYNOS_DSI_CMD_SEQ(0xB0, 0x27, 0xF2 ),
+	EXYNOS_DSI_CMD_SEQ(0xF2, 0x00),
+	EXYNOS_DSI_CMD0(freq_update),
+
+	/* IRC setting for HBM */
+	EXYNOS_DSI_CMD_SEQ_REV(PANEL_REV_PROTO1, 0xB0, 0x0B, 0x8F),
+	EXYNOS_DSI_CMD_SEQ_REV(PANEL_REV_PROTO1, 0x8F, 0x2B),
+
+	/* Enable FD in display PMIC for ELVDD and ELVSS */
+	EXYNOS_DSI_CMD_SEQ_REV(PANEL_REV_LT(PANEL_REV_EVT1), 0xB0, 0x0B, 0xF4),
+	EXYNOS_DSI_CMD_SEQ_REV(PANEL_REV_LT(PANEL_REV_EVT1), 0xF4, 0x1C),
+
+	/* Local HBM circle location setting */
+	EXYNOS_DSI_CMD0(test_key_on_f1),
+	EXYNOS_DSI_CMD_SEQ(0xB0, 0x28, 0xF2),
+	EXYNOS_DSI_CMD_SEQ(0xF2, 0xCC),
+	EXYNOS_DSI_CMD_SEQ(0xB0, 0x01, 0x34, 0x68),
+	EXYNOS_DSI_CMD_SEQ(0x68, 0x21, 0xC6, 0xB3),
+	EXYNOS_DSI_CMD_SEQ(0xB0, 0x00, 0x28, 0xF2),
+	EXYNOS_DSI_CMD_SEQ(0xF2, 0xC4),
+	EXYNOS_DSI_CMD0(test_key_off_f1),
+
+	EXYNOS_DSI_CMD0(test_key_off_f0)
+};
+static DEFINE_EXYNOS_CMD_SET(s6e3fc3_6a_init);
+
+static void s6e3fc3_6a_hist_add(struct s6e3fc3_6a_hist *hist, u32 us)
+{
+	int idx = us ? min(ilog2(us) + 1, s6e3fc3_6a_HIST_BUCKETS - 1) : 0;
+
+	hist->bucket[idx]++;
+	hist->count++;
+	hist->sum_us += us;
+	hist->max_us = max(hist->max_us, us);
+}
+
+static void s6e3fc3_6a_hist_show(struct seq_file *m, const char *name,
+				 const struct s6e3fc3_6a_hist *hist)
+{
+	int i;
+
+	seq_printf(m, "%s: count=%u max=%u avg=%llu\n", name, hist->count,
+		   hist->max_us, hist->count ? div_u64(hist->sum_us, hist->count) : 0);
+	for (i = 0; i < s6e3fc3_6a_HIST_BUCKETS; i++) {
+		if (!hist->bucket[i])
+			continue;
+		if (i == s6e3fc3_6a_HIST_BUCKETS - 1)
+			seq_printf(m, "  >=%u: %u\n", 1U << (i - 1), hist->bucket[i]);
+		else
+			seq_printf(m, "  <%u: %u\n", 1U << i, hist->bucket[i]);
+	}
+}
+
+static struct drm_crtc *s6e3fc3_6a_get_crtc(struct exynos_panel *ctx)
+{
+	struct drm_encoder *encoder = ctx->bridge.encoder;
+
+	return encoder ? encoder->crtc : NULL;
+}
+
+/* returns false without waiting when vblank is not available, e.g. crtc off */
+static bool s6e3fc3_6a_wait_one_vblank(struct exynos_panel *ctx)
+{
+	struct drm_crtc *crtc = s6e3fc3_6a_get_crtc(ctx);
+
+	if (!crtc || drm_crtc_vblank_get(crtc))
+		return false;
+
+	drm_crtc_wait_one_vblank(crtc);
+	drm_crtc_vblank_put(crtc);
+
+	return true;
+}
+
+static void s6e3fc3_6a_usleep(struct exynos_panel *ctx, u32 min_us, u32 max_us)
+{
+	struct s6e3fc3_6a_io_stats *stats = &to_spanel(ctx)->io_stats;
+	ktime_t start = ktime_get();
+
+	usleep_range(min_us, max_us);
+
+	stats->sleeps++;
+	stats->sleep_us += ktime_us_delta(ktime_get(), start);
+}
+
+/*
+ * TE period of the rate the panel is actually running at. Idle and the thermal
+ * cap lower that rate behind the back of DRM, so the current mode is only used
+ * before the first frequency write.
+ */
+static u32 s6e3fc3_6a_te_period_us(struct exynos_panel *ctx)
+{
+	u32 vrefresh = to_spanel(ctx)->freq_stats.vrefresh;
+
+	if (!vrefresh && ctx->current_mode)
+		vrefresh = drm_mode_vrefresh(&ctx->current_mode->mode);
+
+	return vrefresh ? USEC_PER_SEC / vrefresh : 0;
+}
+
+/*
+ * Commands sent too close to the next TE may or may not be latched by it, wait
+ * for that TE to pass so they land on a known frame.
+ */
+static void s6e3fc3_6a_te_guard(struct exynos_panel *ctx, ktime_t now)
+{
+	struct drm_crtc *crtc = s6e3fc3_6a_get_crtc(ctx);
+	u32 period_us, to_te_us;
+	ktime_t last_te;
+	u32 rem;
+
+	period_us = s6e3fc3_6a_te_period_us(ctx);
+	if (!crtc || !period_us)
+		return;
+
+	drm_crtc_vblank_count_and_time(crtc, &last_te);
+	div_u64_rem(ktime_us_delta(now, last_te), period_us, &rem);
+	to_te_us = period_us - rem;
+	if (to_te_us < s6e3fc3_6a_TE_GUARD_US)
+		s6e3fc3_6a_usleep(ctx, to_te_us, to_te_us + 100);
+}
+
+static void s6e3fc3_6a_op_done(struct exynos_panel *ctx, enum s6e3fc3_6a_op op,
+			       ktime_t start)
+{
+	u32 us = ktime_us_delta(ktime_get(), start);
+
+	s6e3fc3_6a_hist_add(&to_spanel(ctx)->op_hist[op], us);
+	trace_s6e3fc3_6a_op(s6e3fc3_6a_op_names[op], us);
+}
+
+/*
+ * Commands written with EXYNOS_DSI_MSG_QUEUE set are held in the DSIM command
+ * FIFO and go out together with the next command written without it, so a
+ * whole sequence costs a single LP/HS turnaround. Packets are not merged, the
+ * bytes on the wire are the same as sending each command on its own.
+ */
+#ifndef EXYNOS_DSI_MSG_QUEUE
+#error "s6e3fc3_6a needs a DSIM driver that supports EXYNOS_DSI_MSG_QUEUE"
+#endif
+
+static void s6e3fc3_6a_shadow_invalidate(struct exynos_panel *ctx, u32 mask)
+{
+	to_spanel(ctx)->shadow.valid &= ~mask;
+}
+
+/* runs the health check right away unless a recovery is already under way */
+static void s6e3fc3_6a_esd_kick(struct exynos_panel *ctx)
+{
+	struct s6e3fc3_6a_esd *esd = &to_spanel(ctx)->esd;
+
+	if (esd->period_ms && !esd->busy)
+		mod_delayed_work(system_wq, &esd->work, 0);
+}
+
+static int s6e3fc3_6a_dcs_write_flags(struct exynos_panel *ctx, const void *data,
+				      size_t len, u16 flags)
+{
+	struct mipi_dsi_device *dsi = to_mipi_dsi_device(ctx->dev);
+	const u8 *msg_data = data;
+	ktime_t start, duration;
+	ssize_t ret;
+
+	if (!len)
+		return -EINVAL;
+
+	start = ktime_get();
+	ret = exynos_dsi_dcs_write_buffer(dsi, data, len, flags);
+	duration = ktime_sub(ktime_get(), start);
+
+	s6e3fc3_6a_hist_add(&to_spanel(ctx)->op_hist[s6e3fc3_6a_OP_DCS_WRITE],
+			    ktime_to_us(duration));
+	to_spanel(ctx)->io_stats.tx_count++;
+	to_spanel(ctx)->io_stats.tx_bytes += len;
+	if (ret < 0) {
+		/*
+		 * The shadow was updated before the write, and a failed flush
+		 * doesn't tell which of the queued writes made it.
+		 */
+		s6e3fc3_6a_shadow_invalidate(ctx, ~0);
+		to_spanel(ctx)->io_stats.tx_errors++;
+		s6e3fc3_6a_esd_kick(ctx);
+	}
+	trace_s6e3fc3_6a_dcs_write(msg_data[0], len,
+				   !!(flags & EXYNOS_DSI_MSG_QUEUE),
+				   ktime_to_ns(duration));
+
+	return ret;
+}
+
+static int s6e3fc3_6a_dcs_read(struct exynos_panel *ctx, u8 cmd, void *data,
+			       size_t len)
+{
+	struct mipi_dsi_device *dsi = to_mipi_dsi_device(ctx->dev);
+	ktime_t start = ktime_get();
+	ktime_t duration;
+	ssize_t ret;
+
+	ret = mipi_dsi_dcs_read(dsi, cmd, data, len);
+	duration = ktime_sub(ktime_get(), start);
+
+	s6e3fc3_6a_hist_add(&to_spanel(ctx)->op_hist[s6e3fc3_6a_OP_DCS_READ],
+			    ktime_to_us(duration));
+	to_spanel(ctx)->io_stats.rx_count++;
+	if (ret > 0)
+		to_spanel(ctx)->io_stats.rx_bytes += ret;
+	else if (ret < 0)
+		to_spanel(ctx)->io_stats.rx_errors++;
+	trace_s6e3fc3_6a_dcs_read(cmd, len, ret, ktime_to_ns(duration));
+
+	return ret;
+}
+
+#define s6e3fc3_6a_DCS_WRITE_FLAGS(ctx, flags, data, len) do {			\
+	int ret = s6e3fc3_6a_dcs_write_flags(ctx, data, len, flags);		\
+	if (ret < 0)								\
+		dev_err(ctx->dev, "failed to write cmd(%d)\n", ret);		\
+} while (0)
+
+#define s6e3fc3_6a_DCS_BUF_ADD(ctx, seq...) do {				\
+	const u8 d[] = { seq };							\
+	s6e3fc3_6a_DCS_WRITE_FLAGS(ctx, EXYNOS_DSI_MSG_QUEUE, d, ARRAY_SIZE(d)); \
+} while (0)
+
+#define s6e3fc3_6a_DCS_BUF_ADD_AND_FLUSH(ctx, seq...) do {			\
+	const u8 d[] = { seq };							\
+	s6e3fc3_6a_DCS_WRITE_FLAGS(ctx, 0, d, ARRAY_SIZE(d));			\
+} while (0)
+
+#define s6e3fc3_6a_DCS_BUF_ADD_TABLE(ctx, table) \
+	s6e3fc3_6a_DCS_WRITE_FLAGS(ctx, EXYNOS_DSI_MSG_QUEUE, table, ARRAY_SIZE(table))
+
+#define s6e3fc3_6a_DCS_BUF_ADD_TABLE_AND_FLUSH(ctx, table) \
+	s6e3fc3_6a_DCS_WRITE_FLAGS(ctx, 0, table, ARRAY_SIZE(table))
+
+/*
+ * Same as exynos_panel_send_cmd_set(), but commands without a delay are
+ * queued and flushed as one burst. A command with a delay, or the last command
+ * that applies to this panel revision, closes the current burst.
+ */
+static void s6e3fc3_6a_send_cmd_set_batched(struct exynos_panel *ctx,
+					    const struct exynos_dsi_cmd_set *cmd_set)
+{
+	const struct exynos_dsi_cmd *c, *last = NULL;
+	const struct exynos_dsi_cmd *end = cmd_set->cmds + cmd_set->num_cmd;
+	ktime_t start = ktime_get();
+	u32 num_cmd = 0, len = 0;
+	u8 opcode = 0;
+
+	for (c = cmd_set->cmds; c < end; c++)
+		if (!c->panel_rev || (c->panel_rev & ctx->panel_rev))
+			last = c;
+
+	if (!last)
+		return;
+
+	for (c = cmd_set->cmds; c < end; c++) {
+		u16 flags = EXYNOS_DSI_MSG_QUEUE;
+
+		if (c->panel_rev && !(c->panel_rev & ctx->panel_rev))
+			continue;
+
+		if (c->delay_ms || c == last)
+			flags = 0;
+
+		s6e3fc3_6a_DCS_WRITE_FLAGS(ctx, flags, c->cmd, c->cmd_len);
+		if (!num_cmd)
+			opcode = c->cmd[0];
+		num_cmd++;
+		len += c->cmd_len;
+
+		if (c->delay_ms)
+			s6e3fc3_6a_usleep(ctx, c->delay_ms * 1000, c->delay_ms * 1000 + 10);
+	}
+
+	s6e3fc3_6a_hist_add(&to_spanel(ctx)->op_hist[s6e3fc3_6a_OP_CMD_SET],
+			    ktime_us_delta(ktime_get(), start));
+	trace_s6e3fc3_6a_cmd_set(opcode, num_cmd, len,
+				 ktime_to_ns(ktime_sub(ktime_get(), start)));
+}
+
+static void s6e3fc3_6a_freq_stats_update(struct exynos_panel *ctx, u32 vrefresh)
+{
+	struct s6e3fc3_6a_freq_stats *stats = &to_spanel(ctx)->freq_stats;
+	ktime_t now = ktime_get();
+	u64 ms = ktime_ms_delta(now, stats->since);
+
+	if (stats->vrefresh == 60)
+		stats->ms_60hz += ms;
+	else if (stats->vrefresh == 90)
+		stats->ms_90hz += ms;
+
+	stats->vrefresh = vrefresh;
+	stats->since = now;
+}
+
+static enum s6e3fc3_6a_power_state s6e3fc3_6a_power_state(struct exynos_panel *ctx)
+{
+	struct s6e3fc3_6a_panel *spanel = to_spanel(ctx);
+
+	BUILD_BUG_ON(ARRAY_SIZE(s6e3fc3_6a_binned_lp) !=
+		     s6e3fc3_6a_PS_MAX - s6e3fc3_6a_PS_LP_OFF);
+
+	if (spanel->aod.lp_start)
+		return spanel->aod.bin < 0 ? s6e3fc3_6a_PS_LP :
+		       s6e3fc3_6a_PS_LP_OFF + spanel->aod.bin;
+	if (!spanel->freq_stats.vrefresh)
+		return s6e3fc3_6a_PS_OFF;
+	if (ctx->hbm.local_hbm.enabled)
+		return s6e3fc3_6a_PS_LHBM;
+	if (IS_HBM_ON_IRC_OFF(ctx->hbm_mode))
+		return s6e3fc3_6a_PS_HBM_IRC_OFF;
+	if (IS_HBM_ON(ctx->hbm_mode))
+		return s6e3fc3_6a_PS_HBM;
+
+	return spanel->freq_stats.vrefresh == 90 ? s6e3fc3_6a_PS_90HZ : s6e3fc3_6a_PS_60HZ;
+}
+
+static BLOCKING_NOTIFIER_HEAD(s6e3fc3_6a_notifier);
+
+int s6e3fc3_6a_register_notifier(struct notifier_block *nb)
+{
+	return blocking_notifier_chain_register(&s6e3fc3_6a_notifier, nb);
+}
+
+int s6e3fc3_6a_unregister_notifier(struct notifier_block *nb)
+{
+	return blocking_notifier_chain_unregister(&s6e3fc3_6a_notifier, nb);
+}
+
+#ifndef s6e3fc3_6a_KUNIT_TEST
+EXPORT_SYMBOL_GPL(s6e3fc3_6a_register_notifier);
+EXPORT_SYMBOL_GPL(s6e3fc3_6a_unregister_notifier);
+#endif
+
+/*
+ * Publishes the refresh rate, power state and TE2 edges to peer drivers when
+ * any of them changed since the last event. The TE timestamp is refreshed on
+ * every event but does not trigger one by itself, listeners extrapolate it
+ * with te_period_us.
+ */
+static void s6e3fc3_6a_notify(struct exynos_panel *ctx)
+{
+	struct s6e3fc3_6a_panel *spanel = to_spanel(ctx);
+	struct s6e3fc3_6a_notify *notify = &spanel->notify;
+	struct s6e3fc3_6a_notify_data data = { .dev = ctx->dev };
+	struct exynos_panel_te2_timing timing;
+	struct drm_crtc *crtc = s6e3fc3_6a_get_crtc(ctx);
+	ktime_t start;
+
+	data.lp = !!spanel->aod.lp_start;
+	/* set_lp_mode runs before the common driver switches current_mode */
+	if (data.lp && ctx->desc->lp_mode)
+		data.vrefresh = drm_mode_vrefresh(&ctx->desc->lp_mode->mode);
+	else
+		data.vrefresh = spanel->freq_stats.vrefresh;
+	if (data.vrefresh) {
+		data.te_period_us = USEC_PER_SEC / data.vrefresh;
+		data.hbm = IS_HBM_ON(ctx->hbm_mode);
+		data.lhbm = ctx->hbm.local_hbm.enabled;
+		if (ctx->panel_rev != PANEL_REV_PROTO1 && ctx->current_mode &&
+		    !exynos_panel_get_current_mode_te2(ctx, &timing)) {
+			data.te2_rising = timing.rising_edge;
+			data.te2_falling = timing.falling_edge;
+		}
+	}
+
+	mutex_lock(&notify->lock);
+	if (data.vrefresh == notify->last.vrefresh && data.lp == notify->last.lp &&
+	    data.hbm == notify->last.hbm && data.lhbm == notify->last.lhbm &&
+	    data.te2_rising == notify->last.te2_rising &&
+	    data.te2_falling == notify->last.te2_falling) {
+		mutex_unlock(&notify->lock);
+		return;
+	}
+
+	if (crtc && data.vrefresh)
+		drm_crtc_vblank_count_and_time(crtc, &data.te);
+
+	notify->last = data;
+	notify->events++;
+
+	start = ktime_get();
+	blocking_notifier_call_chain(&s6e3fc3_6a_notifier, s6e3fc3_6a_NOTIFY_STATE, &data);
+	s6e3fc3_6a_hist_add(&notify->hist, ktime_us_delta(ktime_get(), start));
+	mutex_unlock(&notify->lock);
+
+	dev_dbg(ctx->dev, "%s: %uhz lp=%d hbm=%d lhbm=%d te2=%u-%u\n", __func__,
+		data.vrefresh, data.lp, data.hbm, data.lhbm, data.te2_rising, data.te2_falling);
+}
+
+/* called at the end of every callback that may change the power state */
+static void s6e3fc3_6a_power_stats_update(struct exynos_panel *ctx)
+{
+	struct s6e3fc3_6a_power_stats *stats = &to_spanel(ctx)->power_stats;
+	enum s6e3fc3_6a_power_state state = s6e3fc3_6a_power_state(ctx);
+	const bool dimming = ctx->dimming_on && state != s6e3fc3_6a_PS_OFF;
+	ktime_t now = ktime_get();
+
+	if (state != stats->state) {
+		stats->ms[stats->state] += ktime_ms_delta(now, stats->since);
+		stats->transitions[stats->state][state]++;
+		stats->state = state;
+		stats->since = now;
+	}
+
+	if (dimming && !stats->dimming_since) {
+		stats->dimming_since = now;
+	} else if (!dimming && stats->dimming_since) {
+		stats->dimming_ms += ktime_ms_delta(now, stats->dimming_since);
+		stats->dimming_since = 0;
+	}
+
+	stats->updates++;
+	stats->update_ns += ktime_to_ns(ktime_sub(ktime_get(), now));
+
+	s6e3fc3_6a_notify(ctx);
+}
+
+/*
+ * Returns true if @val has to be written to the panel, in which case the cache
+ * is updated with it; returns false if the panel already holds @val.
+ */
+static bool s6e3fc3_6a_shadow_update(struct exynos_panel *ctx, u32 reg,
+				     u8 *cache, const u8 *val, size_t len)
+{
+	struct s6e3fc3_6a_shadow *shadow = &to_spanel(ctx)->shadow;
+
+	if ((shadow->valid & reg) && !memcmp(cache, val, len)) {
+		shadow->hit++;
+		return false;
+	}
+
+	memcpy(cache, val, len);
+	shadow->valid |= reg;
+	shadow->miss++;
+	return true;
+}
+
+static void s6e3fc3_6a_get_te2_setting(struct exynos_panel_te2_timing *timing,
+				    u8 *setting)
+{
+	u8 delay_low_byte, delay_high_byte;
+	u8 width_low_byte, width_high_byte;
+	u32 delay, width = 0;
+
+	if (!timing || !setting)
+		return;
+
+	/* out of range edges are clamped rather than wrapped into the 12-bit fields */
+	delay = min_t(u32, timing->rising_edge, s6e3fc3_6a_TE2_EDGE_MAX);
+	if (timing->falling_edge > timing->rising_edge)
+		width = min_t(u32, timing->falling_edge - timing->rising_edge,
+			      s6e3fc3_6a_TE2_EDGE_MAX);
+
+	delay_low_byte = delay & 0xFF;
+	delay_high_byte = (delay >> 8) & 0xF;
+	width_low_byte = width & 0xFF;
+	width_high_byte = (width >> 8) & 0xF;
+
+	setting[0] = (delay_high_byte << 4) | width_high_byte;
+	setting[1] = delay_low_byte;
+	setting[2] = width_low_byte;
+}
+
+/**
+ * struct s6e3fc3_6a_te2_reg - location of the TE2 0xCB setting of a mode
+ */
+struct s6e3fc3_6a_te2_reg {
+	/** @vrefresh: refresh rate of the mode */
+	u32 vrefresh;
+	/** @lp: setting belongs to the LP mode rather than a normal mode */
+	bool lp;
+	/** @offset: 0xB0 global parameter offset of the setting in 0xCB */
+	u8 offset[2];
+	/** @dft: setting used until the panel reports its TE2 timing */
+	u8 dft[s6e3fc3_6a_TE2_SETTING_LEN];
+};
+
+static const struct s6e3fc3_6a_te2_reg s6e3fc3_6a_te2_regs[] = {
+	{ .vrefresh = 60, .offset = { 0x00, 0xAF }, .dft = { 0x00, 0x00, 0x30 } },
+	{ .vrefresh = 90, .offset = { 0x01, 0x2F }, .dft = { 0x00, 0x00, 0x30 } },
+	{ .vrefresh = 30, .lp = true, .offset = { 0x01, 0xAF },
+	  .dft = { 0x00, 0x00, 0x10 } }, /* lp low/high */
+};
+
+static int s6e3fc3_6a_te2_timing(struct exynos_panel *ctx,
+				 const struct s6e3fc3_6a_te2_reg *reg,
+				 struct exynos_panel_te2_timing *timing)
+{
+	int i;
+
+	if (reg->lp)
+		return exynos_panel_get_current_mode_te2(ctx, timing);
+
+	for (i = 0; i < ctx->desc->num_modes; i++) {
+		if (drm_mode_vrefresh(&ctx->desc->modes[i].mode) != reg->vrefresh)
+			continue;
+		timing->rising_edge = ctx->te2.mode_data[i].timing.rising_edge;
+		timing->falling_edge = ctx->te2.mode_data[i].timing.falling_edge;
+		return 0;
+	}
+
+	return -ENOENT;
+}
+
+static void s6e3fc3_6a_update_te2(struct exynos_panel *ctx)
+{
+	struct s6e3fc3_6a_shadow *shadow;
+	struct exynos_panel_te2_timing timing;
+	u8 setting[ARRAY_SIZE(s6e3fc3_6a_te2_regs)][s6e3fc3_6a_TE2_SETTING_LEN + 1];
+	unsigned long present = 0, dirty = 0;
+	ktime_t start = ktime_get();
+	bool is_lp_mode;
+	int ret, i;
+
+	BUILD_BUG_ON(ARRAY_SIZE(s6e3fc3_6a_te2_regs) > s6e3fc3_6a_TE2_MAX);
+
+	if (!ctx)
+		return;
+
+	shadow = &to_spanel(ctx)->shadow;
+	is_lp_mode = ctx->current_mode->exynos_mode.is_lp_mode;
+
+	if (ctx->panel_rev == PANEL_REV_PROTO1) {
+		dev_dbg(ctx->dev, "No need to send TE2 commands on P1.0\n");
+		return;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(s6e3fc3_6a_te2_regs); i++) {
+		const struct s6e3fc3_6a_te2_reg *reg = &s6e3fc3_6a_te2_regs[i];
+
+		/* the LP setting is only programmed while in LP mode */
+		if (reg->lp && !is_lp_mode)
+			continue;
+
+		setting[i][0] = 0xCB;
+		memcpy(&setting[i][1], reg->dft, s6e3fc3_6a_TE2_SETTING_LEN);
+
+		ret = s6e3fc3_6a_te2_timing(ctx, reg, &timing);
+		if (!ret)
+			s6e3fc3_6a_get_te2_setting(&timing, &setting[i][1]);
+		else if (ret == -EAGAIN)
+			dev_dbg(ctx->dev,
+				"Panel is not ready, use default setting\n");
+		else if (reg->lp)
+			return;
+
+		dev_dbg(ctx->dev, "TE2 updated %s %uHz: 0xcb 0x%x 0x%x 0x%x\n",
+			reg->lp ? "LP" : "normal", reg->vrefresh,
+			setting[i][1], setting[i][2], setting[i][3]);
+		present |= BIT(i);
+	}
+
+	/* only rewrite the settings whose edges changed */
+	for_each_set_bit(i, &present, ARRAY_SIZE(s6e3fc3_6a_te2_regs))
+		if (s6e3fc3_6a_shadow_update(ctx, s6e3fc3_6a_SHADOW_TE2(i), shadow->te2[i],
+					     &setting[i][1], s6e3fc3_6a_TE2_SETTING_LEN))
+			dirty |= BIT(i);
+
+	if (!dirty)
+		return;
+
+	s6e3fc3_6a_DCS_BUF_ADD_TABLE(ctx, test_key_on_f0);
+	s6e3fc3_6a_DCS_BUF_ADD(ctx, 0xB0, 0x28, 0xF2); /* global para  */
+	s6e3fc3_6a_DCS_BUF_ADD(ctx, 0xF2, 0xCC); /* global para 10bit */
+	s6e3fc3_6a_DCS_BUF_ADD(ctx, 0xB0, 0x00, 0x26, 0xF2); /* global para */
+	s6e3fc3_6a_DCS_BUF_ADD(ctx, 0xF2, 0x03, 0x14); /* TE2 on */
+	for_each_set_bit(i, &dirty, ARRAY_SIZE(s6e3fc3_6a_te2_regs)) {
+		const struct s6e3fc3_6a_te2_reg *reg = &s6e3fc3_6a_te2_regs[i];
+
+		/* global para */
+		s6e3fc3_6a_DCS_BUF_ADD(ctx, 0xB0, reg->offset[0], reg->offset[1], 0xCB);
+		s6e3fc3_6a_DCS_BUF_ADD_TABLE(ctx, setting[i]);
+	}
+	s6e3fc3_6a_DCS_BUF_ADD(ctx, 0xB0, 0x00, 0x28, 0xF2); /* global para */
+	s6e3fc3_6a_DCS_BUF_ADD(ctx, 0xF2, 0xC4); /* global para 8bit */
+	s6e3fc3_6a_DCS_BUF_ADD_TABLE(ctx, freq_update); /* LTPS update */
+	s6e3fc3_6a_DCS_BUF_ADD_TABLE_AND_FLUSH(ctx, test_key_off_f0);
+
+	s6e3fc3_6a_op_done(ctx, s6e3fc3_6a_OP_TE2, start);
+	s6e3fc3_6a_notify(ctx);
+}
+
+/*
+ * Returns true if the 0x60 frequency setting @val for @vrefresh has to be sent,
+ * @vrefresh is updated to the rate the panel will actually run at.
+ */
+static bool s6e3fc3_6a_freq_prepare(struct exynos_panel *ctx, unsigned int *vrefresh,
+				    u8 *val)
+{
+	if (*vrefresh != 60 && *vrefresh != 90)
+		return false;
+
+	if (to_spanel(ctx)->thermal.state >= s6e3fc3_6a_THERMAL_60HZ)
+		*vrefresh = 60;
+
+	*val = (*vrefresh == 90) ? 0x10 : 0x00;
+	if (!s6e3fc3_6a_shadow_update(ctx, s6e3fc3_6a_SHADOW_FREQ,
+				      &to_spanel(ctx)->shadow.freq, val, 1)) {
+		dev_dbg(ctx->dev, "%s: already at %uhz\n", __func__, *vrefresh);
+		return false;
+	}
+
+	return true;
+}
+
+static void s6e3fc3_6a_change_frequency(struct exynos_panel *ctx,
+				     unsigned int vrefresh)
+{
+	ktime_t start = ktime_get();
+	u8 val;
+
+	if (!ctx || !s6e3fc3_6a_freq_prepare(ctx, &vrefresh, &val))
+		return;
+
+	s6e3fc3_6a_DCS_BUF_ADD_TABLE(ctx, test_key_on_f0);
+	s6e3fc3_6a_DCS_BUF_ADD(ctx, 0x60, val);
+	s6e3fc3_6a_DCS_BUF_ADD_TABLE(ctx, freq_update);
+	s6e3fc3_6a_DCS_BUF_ADD_TABLE_AND_FLUSH(ctx, test_key_off_f0);
+
+	s6e3fc3_6a_freq_stats_update(ctx, vrefresh);
+	s6e3fc3_6a_power_stats_update(ctx);
+	s6e3fc3_6a_op_done(ctx, s6e3fc3_6a_OP_FREQ, start);
+
+	dev_dbg(ctx->dev, "%s: change to %uhz\n", __func__, vrefresh);
+}
+
+static u8 s6e3fc3_6a_wrctrld_val(struct exynos_panel *ctx)
+{
+	u8 val = s6e3fc3_6a_WRCTRLD_BCTRL_BIT;
+
+	if (IS_HBM_ON(ctx->hbm_mode))
+		val |= s6e3fc3_6a_WRCTRLD_HBM_BIT;
+
+	if (ctx->hbm.local_hbm.enabled)
+		val |= s6e3fc3_6a_WRCTRLD_LOCAL_HBM_BIT;
+
+	if (ctx->dimming_on)
+		val |= s6e3fc3_6a_WRCTRLD_DIMMING_BIT;
+
+	dev_dbg(ctx->dev,
+		"%s(wrctrld:0x%x, hbm: %s, dimming: %s, local_hbm: %s)\n",
+		__func__, val, IS_HBM_ON(ctx->hbm_mode) ? "on" : "off",
+		ctx->dimming_on ? "on" : "off",
+		ctx->hbm.local_hbm.enabled ? "on" : "off");
+
+	return val;
+}
+
+static void s6e3fc3_6a_update_wrctrld(struct exynos_panel *ctx)
+{
+	u8 val = s6e3fc3_6a_wrctrld_val(ctx);
+
+	if (s6e3fc3_6a_shadow_update(ctx, s6e3fc3_6a_SHADOW_WRCTRLD,
+				     &to_spanel(ctx)->shadow.wrctrld, &val, 1))
+		s6e3fc3_6a_DCS_BUF_ADD_AND_FLUSH(ctx, MIPI_DCS_WRITE_CONTROL_DISPLAY, val);
+
+	/* TODO: need to perform gamma updates */
+}
+
+/*
+ * Queues the payload of a PROTO1.1 PWM command set without its leading
+ * test_key_on_f0 and trailing freq_update/test_key_off_f0, so it can share
+ * the unlock and latch of s6e3fc3_6a_state_flush().
+ */
+static void s6e3fc3_6a_queue_pwm(struct exynos_panel *ctx,
+				 const struct exynos_dsi_cmd_set *cmd_set)
+{
+	u32 i;
+
+	for (i = 1; i + 2 < cmd_set->num_cmd; i++)
+		s6e3fc3_6a_DCS_WRITE_FLAGS(ctx, EXYNOS_DSI_MSG_QUEUE,
+					   cmd_set->cmds[i].cmd, cmd_set->cmds[i].cmd_len);
+}
+
+/*
+ * Sends the pending state as a single burst: PWM, IRC and frequency behind one
+ * test key unlock and one freq_update latch, then WRCTRLD. Registers already
+ * holding the wanted value are skipped through the shadow cache.
+ */
+static void s6e3fc3_6a_state_flush(struct exynos_panel *ctx, bool te_aligned)
+{
+	struct s6e3fc3_6a_panel *spanel = to_spanel(ctx);
+	struct s6e3fc3_6a_state *st = &spanel->state;
+	struct drm_crtc *crtc = s6e3fc3_6a_get_crtc(ctx);
+	const u32 pending = st->pending;
+	const u32 tx_count = spanel->io_stats.tx_count;
+	const u8 irc = IS_HBM_ON_IRC_OFF(ctx->hbm_mode) ? 0x05 : 0x25;
+	const struct exynos_dsi_cmd_set *pwm = NULL;
+	unsigned int vrefresh = st->vrefresh;
+	const bool need_brightness = pending & s6e3fc3_6a_STATE_BRIGHTNESS;
+	bool need_irc = false, need_freq = false, need_wrctrld = false;
+	u8 freq = 0, wrctrld = 0;
+	u64 vblank = 0;
+
+	if (!pending)
+		return;
+
+	st->pending = 0;
+	/* the work rechecks the pending state under mode_lock, no need to sync */
+	cancel_delayed_work(&st->flush_work);
+
+	if (te_aligned)
+		s6e3fc3_6a_te_guard(ctx, ktime_get());
+	if (crtc)
+		vblank = drm_crtc_vblank_count(crtc);
+
+	if ((pending & s6e3fc3_6a_STATE_PWM) && ctx->panel_rev == PANEL_REV_PROTO1_1)
+		pwm = IS_HBM_ON(ctx->hbm_mode) ? &s6e3fc3_6a_1_pwm_cmd_set :
+						 &s6e3fc3_6a_4_pwm_cmd_set;
+
+	if (pending & s6e3fc3_6a_STATE_IRC)
+		need_irc = s6e3fc3_6a_shadow_update(ctx, s6e3fc3_6a_SHADOW_IRC,
+						    &spanel->shadow.irc, &irc, 1);
+	if (pending & s6e3fc3_6a_STATE_FREQ)
+		need_freq = s6e3fc3_6a_freq_prepare(ctx, &vrefresh, &freq);
+	if (pending & s6e3fc3_6a_STATE_WRCTRLD) {
+		wrctrld = s6e3fc3_6a_wrctrld_val(ctx);
+		need_wrctrld = s6e3fc3_6a_shadow_update(ctx, s6e3fc3_6a_SHADOW_WRCTRLD,
+							&spanel->shadow.wrctrld,
+							&wrctrld, 1);
+	}
+
+	if (pwm || need_irc || need_freq) {
+		s6e3fc3_6a_DCS_BUF_ADD_TABLE(ctx, test_key_on_f0);
+		if (pwm)
+			s6e3fc3_6a_queue_pwm(ctx, pwm);
+		if (need_irc) {
+			s6e3fc3_6a_DCS_BUF_ADD(ctx, 0xB0, 0x03, 0x8F); /* global para */
+			s6e3fc3_6a_DCS_BUF_ADD(ctx, 0x8F, irc);
+		}
+		if (need_freq)
+			s6e3fc3_6a_DCS_BUF_ADD(ctx, 0x60, freq);
+		if (pwm || need_freq)
+			s6e3fc3_6a_DCS_BUF_ADD_TABLE(ctx, freq_update);
+		if (need_wrctrld || need_brightness)
+			s6e3fc3_6a_DCS_BUF_ADD_TABLE(ctx, test_key_off_f0);
+		else
+			s6e3fc3_6a_DCS_BUF_ADD_TABLE_AND_FLUSH(ctx, test_key_off_f0);
+	}
+	if (need_wrctrld && need_brightness)
+		s6e3fc3_6a_DCS_BUF_ADD(ctx, MIPI_DCS_WRITE_CONTROL_DISPLAY, wrctrld);
+	else if (need_wrctrld)
+		s6e3fc3_6a_DCS_BUF_ADD_AND_FLUSH(ctx, MIPI_DCS_WRITE_CONTROL_DISPLAY, wrctrld);
+	/* after the HBM switch, an HBM level must not reach the panel ahead of it */
+	if (need_brightness)
+		s6e3fc3_6a_DCS_BUF_ADD_AND_FLUSH(ctx, MIPI_DCS_SET_DISPLAY_BRIGHTNESS,
+						 st->brightness >> 8, st->brightness & 0xFF);
+
+	if (need_freq) {
+		s6e3fc3_6a_freq_stats_update(ctx, vrefresh);
+		s6e3fc3_6a_power_stats_update(ctx);
+	}
+
+	s6e3fc3_6a_hist_add(&st->transfers, spanel->io_stats.tx_count - tx_count);
+	if (te_aligned && crtc && drm_crtc_vblank_count(crtc) != vblank)
+		st->spilled++;
+}
+
+/*
+ * Records state changes made by @changes; they are sent at commit_done when
+ * deferring is possible, otherwise right away.
+ */
+static void s6e3fc3_6a_state_commit(struct exynos_panel *ctx, u32 changes)
+{
+	struct s6e3fc3_6a_state *st = &to_spanel(ctx)->state;
+	u32 delay_us;
+
+	st->pending |= changes;
+
+	if (!st->enabled || !ctx->enabled || !ctx->current_mode ||
+	    ctx->current_mode->exynos_mode.is_lp_mode) {
+		s6e3fc3_6a_state_flush(ctx, false);
+		return;
+	}
+
+	/* changes made outside of a commit still go out within two frames */
+	delay_us = 2 * s6e3fc3_6a_te_period_us(ctx);
+	mod_delayed_work(system_highpri_wq, &st->flush_work, usecs_to_jiffies(delay_us));
+}
+
+static void s6e3fc3_6a_state_flush_work(struct work_struct *work)
+{
+	struct s6e3fc3_6a_panel *spanel = container_of(to_delayed_work(work),
+						       struct s6e3fc3_6a_panel,
+						       state.flush_work);
+	struct exynos_panel *ctx = &spanel->base;
+
+	mutex_lock(&ctx->mode_lock);
+	if (ctx->enabled)
+		s6e3fc3_6a_state_flush(ctx, true);
+	mutex_unlock(&ctx->mode_lock);
+}
+
+/* binned LP mode the common driver picks for @brightness */
+static int s6e3fc3_6a_aod_bin(struct exynos_panel *ctx, u16 brightness)
+{
+	int i;
+
+	for (i = 0; i < ctx->desc->num_binned_lp - 1; i++)
+		if (brightness <= ctx->desc->binned_lp[i].bl_threshold)
+			break;
+
+	return i;
+}
+
+static void s6e3fc3_6a_aod_lp_start(struct exynos_panel *ctx)
+{
+	struct s6e3fc3_6a_aod *aod = &to_spanel(ctx)->aod;
+
+	/* exynos_panel_set_lp_mode() applied the bin of the current brightness */
+	aod->bin = ctx->bl ? s6e3fc3_6a_aod_bin(ctx, ctx->bl->props.brightness) : -1;
+	aod->since = ktime_get();
+	if (!aod->lp_start)
+		aod->lp_start = aod->since;
+}
+
+static void s6e3fc3_6a_aod_lp_stop(struct exynos_panel *ctx)
+{
+	struct s6e3fc3_6a_aod *aod = &to_spanel(ctx)->aod;
+
+	aod->bin = -1;
+	/* the work finds LP mode over if it is already running */
+	cancel_delayed_work(&aod->work);
+	if (aod->lp_start) {
+		aod->lp_ms += ktime_ms_delta(ktime_get(), aod->lp_start);
+		aod->lp_start = 0;
+	}
+}
+
+static void s6e3fc3_6a_set_nolp_mode(struct exynos_panel *ctx,
+				  const struct exynos_panel_mode *pmode)
+{
+	struct s6e3fc3_6a_panel *spanel = to_spanel(ctx);
+	unsigned int vrefresh = drm_mode_vrefresh(&pmode->mode);
+	u32 delay_us = mult_frac(1000, 1020, vrefresh);
+	ktime_t start = ktime_get();
+	u32 elapsed_us;
+
+	if (!ctx->enabled)
+		return;
+
+	spanel->idle.vrefresh = vrefresh;
+	s6e3fc3_6a_aod_lp_stop(ctx);
+
+	if (spanel->lp_exit_blocking) {
+		s6e3fc3_6a_DCS_BUF_ADD_TABLE_AND_FLUSH(ctx, display_off);
+		s6e3fc3_6a_update_wrctrld(ctx);
+		s6e3fc3_6a_change_frequency(ctx, vrefresh);
+		s6e3fc3_6a_usleep(ctx, delay_us, delay_us + 10);
+		s6e3fc3_6a_DCS_BUF_ADD_TABLE_AND_FLUSH(ctx, display_on);
+	} else {
+		/*
+		 * WRCTRLD takes the panel out of AOD and the frequency change is
+		 * latched by freq_update, both on the next TE together with the
+		 * first normal frame. The panel stays on, so there is no need to
+		 * hide a transition frame behind display off.
+		 */
+		s6e3fc3_6a_update_wrctrld(ctx);
+		s6e3fc3_6a_change_frequency(ctx, vrefresh);
+		s6e3fc3_6a_DCS_BUF_ADD_TABLE_AND_FLUSH(ctx, display_on);
+	}
+
+	elapsed_us = ktime_us_delta(ktime_get(), start);
+	spanel->lp_exit_last_us = elapsed_us;
+	spanel->lp_exit_max_us = max(spanel->lp_exit_max_us, elapsed_us);
+
+	s6e3fc3_6a_power_stats_update(ctx);
+	s6e3fc3_6a_op_done(ctx, s6e3fc3_6a_OP_NOLP, start);
+
+	dev_info(ctx->dev, "exit LP mode (%uus)\n", elapsed_us);
+}
+
+static void s6e3fc3_6a_idle_stop(struct exynos_panel *ctx)
+{
+	struct s6e3fc3_6a_idle *idle = &to_spanel(ctx)->idle;
+
+	/* the work rechecks the panel state under mode_lock, no need to sync */
+	cancel_delayed_work(&idle->work);
+	idle->active = false;
+}
+
+static void s6e3fc3_6a_idle_work(struct work_struct *work)
+{
+	struct s6e3fc3_6a_panel *spanel = container_of(to_delayed_work(work),
+						       struct s6e3fc3_6a_panel, idle.work);
+	struct exynos_panel *ctx = &spanel->base;
+	struct s6e3fc3_6a_idle *idle = &spanel->idle;
+
+	mutex_lock(&ctx->mode_lock);
+	if (ctx->enabled && idle->frames && !idle->active && ctx->current_mode &&
+	    !ctx->current_mode->exynos_mode.is_lp_mode &&
+	    idle->vrefresh > s6e3fc3_6a_IDLE_VREFRESH) {
+		s6e3fc3_6a_change_frequency(ctx, s6e3fc3_6a_IDLE_VREFRESH);
+		idle->active = true;
+		idle->count++;
+		dev_dbg(ctx->dev, "idle, lower refresh rate to %uhz\n",
+			s6e3fc3_6a_IDLE_VREFRESH);
+	}
+	mutex_unlock(&ctx->mode_lock);
+}
+
+static void s6e3fc3_6a_te_hist_add(struct s6e3fc3_6a_te_hist *hist, u32 us)
+{
+	hist->bucket[min_t(u32, us / s6e3fc3_6a_TE_BUCKET_US, s6e3fc3_6a_TE_BUCKETS - 1)]++;
+	hist->count++;
+	hist->max_us = max(hist->max_us, us);
+}
+
+/* returns the upper bound of the bucket holding the @pct percentile */
+static u32 s6e3fc3_6a_te_hist_percentile(const struct s6e3fc3_6a_te_hist *hist,
+					 u32 pct)
+{
+	u64 target = div_u64((u64)hist->count * pct + 99, 100);
+	u64 seen = 0;
+	int i;
+
+	if (!hist->count)
+		return 0;
+
+	for (i = 0; i < s6e3fc3_6a_TE_BUCKETS - 1; i++) {
+		seen += hist->bucket[i];
+		if (seen >= target)
+			return (i + 1) * s6e3fc3_6a_TE_BUCKET_US;
+	}
+
+	return hist->max_us;
+}
+
+static struct s6e3fc3_6a_te_mode_stats *
+s6e3fc3_6a_te_mode_stats(struct s6e3fc3_6a_te_stats *stats,
+			 const struct exynos_panel_mode *pmode)
+{
+	int i;
+
+	for (i = 0; i < s6e3fc3_6a_TE_MODES_MAX; i++) {
+		if (!stats->mode[i].pmode)
+			stats->mode[i].pmode = pmode;
+		if (stats->mode[i].pmode == pmode)
+			return &stats->mode[i];
+	}
+
+	return NULL;
+}
+
+static void s6e3fc3_6a_te_sample(struct exynos_panel *ctx)
+{
+	struct s6e3fc3_6a_te_stats *stats = &to_spanel(ctx)->te_stats;
+	const struct exynos_panel_mode *pmode = ctx->current_mode;
+	const struct exynos_display_underrun_param *underrun =
+		pmode->exynos_mode.underrun_param;
+	struct s6e3fc3_6a_te_mode_stats *mstats;
+	struct drm_crtc *crtc = s6e3fc3_6a_get_crtc(ctx);
+	const u32 period_us = s6e3fc3_6a_te_period_us(ctx);
+	ktime_t now = ktime_get(), te;
+	u32 since_te_us, slack_us;
+	u64 count;
+
+	if (!crtc)
+		return;
+
+	count = drm_crtc_vblank_count_and_time(crtc, &te);
+	mstats = s6e3fc3_6a_te_mode_stats(stats, pmode);
+	if (!mstats || !te)
+		goto out;
+
+	mstats->frames++;
+	since_te_us = ktime_us_delta(now, te);
+	slack_us = since_te_us < period_us ? period_us - since_te_us : 0;
+	s6e3fc3_6a_te_hist_add(&mstats->slack, slack_us);
+	if (underrun && slack_us < underrun->te_idle_us)
+		mstats->late++;
+
+	/* intervals across a mode or rate switch, or a disable, are meaningless */
+	if (stats->last_pmode != pmode || stats->last_period_us != period_us ||
+	    count <= stats->last_count)
+		goto out;
+
+	if (count == stats->last_count + 1) {
+		u32 interval_us = ktime_us_delta(te, stats->last_te);
+
+		s6e3fc3_6a_te_hist_add(&mstats->jitter, abs((s32)(interval_us - period_us)));
+	} else if (ktime_us_delta(now, stats->last_done) < 2 * period_us) {
+		/* commits came back to back, yet TEs went by without a frame */
+		mstats->missed += count - stats->last_count - 1;
+	}
+
+out:
+	stats->last_pmode = pmode;
+	stats->last_period_us = period_us;
+	stats->last_count = count;
+	stats->last_te = te;
+	stats->last_done = now;
+}
+
+/*
+ * Called after every commit: restores the refresh rate of the current mode if
+ * the panel was downshifted and restarts the idle countdown.
+ */
+static void s6e3fc3_6a_commit_done(struct exynos_panel *ctx)
+{
+	struct s6e3fc3_6a_idle *idle = &to_spanel(ctx)->idle;
+	ktime_t start = ktime_get();
+
+	if (!ctx->enabled || !ctx->current_mode)
+		return;
+
+	s6e3fc3_6a_te_sample(ctx);
+
+	if (ctx->current_mode->exynos_mode.is_lp_mode)
+		return;
+
+	/* the TE guard may sleep, keep it off the atomic commit path */
+	if (to_spanel(ctx)->state.pending)
+		mod_delayed_work(system_highpri_wq, &to_spanel(ctx)->state.flush_work, 0);
+
+	if (to_spanel(ctx)->lhbm.gamma_pending) {
+		to_spanel(ctx)->lhbm.gamma_pending = false;
+		mod_delayed_work(system_unbound_wq, &to_spanel(ctx)->lhbm.gamma_work, 0);
+	}
+
+	if (idle->active) {
+		s6e3fc3_6a_change_frequency(ctx, idle->vrefresh);
+		idle->active = false;
+		s6e3fc3_6a_hist_add(&idle->wakeup, ktime_us_delta(ktime_get(), start));
+	}
+
+	if (idle->frames && idle->vrefresh > s6e3fc3_6a_IDLE_VREFRESH)
+		mod_delayed_work(system_wq, &idle->work,
+				 usecs_to_jiffies(idle->frames * USEC_PER_SEC /
+						  idle->vrefresh));
+}
+
+static void s6e3fc3_6a_set_lp_mode(struct exynos_panel *ctx,
+				   const struct exynos_panel_mode *pmode)
+{
+	s6e3fc3_6a_idle_stop(ctx);
+	s6e3fc3_6a_state_flush(ctx, false);
+	s6e3fc3_6a_freq_stats_update(ctx, 0);
+
+	/* LP commands take over WRCTRLD and the panel runs its own LP refresh */
+	s6e3fc3_6a_shadow_invalidate(ctx, s6e3fc3_6a_SHADOW_WRCTRLD | s6e3fc3_6a_SHADOW_FREQ);
+
+	exynos_panel_set_lp_mode(ctx, pmode);
+
+	s6e3fc3_6a_aod_lp_start(ctx);
+	s6e3fc3_6a_power_stats_update(ctx);
+}
+
+static int s6e3fc3_6a_set_binned_lp(struct exynos_panel *ctx, u16 brightness)
+{
+	struct s6e3fc3_6a_aod *aod = &to_spanel(ctx)->aod;
+	const struct exynos_binned_lp *binned_lp = ctx->desc->binned_lp;
+	int bin = s6e3fc3_6a_aod_bin(ctx, brightness);
+	ktime_t now = ktime_get();
+	s64 dwell_ms;
+	int ret;
+
+	aod->brightness = brightness;
+	if (aod->bin == bin)
+		return 0;
+
+	if (aod->bin > 0 && bin > 0) {
+		const u32 threshold = (bin > aod->bin) ?
+			binned_lp[aod->bin].bl_threshold + aod->hysteresis :
+			binned_lp[bin].bl_threshold;
+
+		dwell_ms = aod->min_dwell_ms - ktime_ms_delta(now, aod->since);
+		if (dwell_ms > 0) {
+			/* hysteresis is checked again with the brightness of then */
+			aod->suppressed++;
+			mod_delayed_work(system_wq, &aod->work, msecs_to_jiffies(dwell_ms));
+			return 0;
+		}
+
+		/* a later brightness request evaluates the bins again */
+		if ((bin > aod->bin && brightness <= threshold) ||
+		    (bin < aod->bin && brightness + aod->hysteresis > threshold)) {
+			aod->suppressed++;
+			return 0;
+		}
+	}
+
+	s6e3fc3_6a_shadow_invalidate(ctx, s6e3fc3_6a_SHADOW_WRCTRLD);
+	ret = exynos_panel_set_binned_lp(ctx, brightness);
+
+	aod->bin = bin;
+	aod->since = now;
+	aod->transitions++;
+	s6e3fc3_6a_power_stats_update(ctx);
+
+	return ret;
+}
+
+static void s6e3fc3_6a_aod_work(struct work_struct *work)
+{
+	struct s6e3fc3_6a_panel *spanel = container_of(to_delayed_work(work),
+						       struct s6e3fc3_6a_panel,
+						       aod.work);
+	struct exynos_panel *ctx = &spanel->base;
+
+	mutex_lock(&ctx->mode_lock);
+	if (ctx->enabled && spanel->aod.lp_start && spanel->aod.bin >= 0)
+		s6e3fc3_6a_set_binned_lp(ctx, spanel->aod.brightness);
+	mutex_unlock(&ctx->mode_lock);
+}
+
+static int s6e3fc3_6a_lhbm_gamma_read(struct exynos_panel *ctx)
+{
+	u8 *gamma_cmd = ctx->hbm.local_hbm.gamma_cmd;
+	ktime_t start = ktime_get();
+	int ret;
+
+	s6e3fc3_6a_DCS_BUF_ADD_TABLE(ctx, test_key_on_f0);
+	s6e3fc3_6a_DCS_BUF_ADD(ctx, 0xB0, 0x28, 0xF2); /* global para*/
+	s6e3fc3_6a_DCS_BUF_ADD(ctx, 0xF2, 0xCC); /* 10 bit */
+	s6e3fc3_6a_DCS_BUF_ADD_AND_FLUSH(ctx, 0xB0, 0x00, 0x22, 0xD8); /* global para */
+	ret = s6e3fc3_6a_dcs_read(ctx, 0xD8, gamma_cmd + 1, s6e3fc3_6a_LOCAL_HBM_GAMMA_CMD_SIZE - 1);
+	if (ret == (s6e3fc3_6a_LOCAL_HBM_GAMMA_CMD_SIZE - 1)) {
+		gamma_cmd[0] = 0x65;
+		ctx->hbm.local_hbm.gamma_para_ready = true;
+		ret = 0;
+	} else {
+		dev_err(ctx->dev, "fail to read LHBM gamma\n");
+		ret = -EIO;
+	}
+	s6e3fc3_6a_DCS_BUF_ADD(ctx, 0xB0, 0x00, 0x28, 0xF2); /* global para*/
+	s6e3fc3_6a_DCS_BUF_ADD(ctx, 0xF2, 0xC4); /* 8 bit */
+	s6e3fc3_6a_DCS_BUF_ADD_TABLE_AND_FLUSH(ctx, test_key_off_f0);
+
+	s6e3fc3_6a_op_done(ctx, s6e3fc3_6a_OP_LHBM_GAMMA_READ, start);
+	return ret;
+}
+
+static void s6e3fc3_6a_lhbm_gamma_write(struct exynos_panel *ctx)
+{
+	s6e3fc3_6a_DCS_BUF_ADD_TABLE(ctx, test_key_on_f0);
+	s6e3fc3_6a_DCS_BUF_ADD(ctx, 0xB0, 0x28, 0xF2); /* global para*/
+	s6e3fc3_6a_DCS_BUF_ADD(ctx, 0xF2, 0xCC); /* 10 bit */
+	s6e3fc3_6a_DCS_BUF_ADD(ctx, 0xB0, 0x03, 0xCD, 0x65); /* global para */
+	s6e3fc3_6a_DCS_WRITE_FLAGS(ctx, EXYNOS_DSI_MSG_QUEUE,
+				   ctx->hbm.local_hbm.gamma_cmd,
+				   s6e3fc3_6a_LOCAL_HBM_GAMMA_CMD_SIZE); /* write gamma */
+	s6e3fc3_6a_DCS_BUF_ADD(ctx, 0xB0, 0x00, 0x28, 0xF2); /* global para*/
+	s6e3fc3_6a_DCS_BUF_ADD(ctx, 0xF2, 0xC4); /* 8 bit */
+	s6e3fc3_6a_DCS_BUF_ADD_TABLE_AND_FLUSH(ctx, test_key_off_f0);
+}
+
+/*
+ * The LHBM gamma readback is a slow LP read, it is done off the boot path and
+ * only if userspace did not restore a saved copy in time.
+ */
+static void s6e3fc3_6a_lhbm_gamma_work(struct work_struct *work)
+{
+	struct s6e3fc3_6a_panel *spanel = container_of(to_delayed_work(work),
+						       struct s6e3fc3_6a_panel,
+						       lhbm.gamma_work);
+	struct exynos_panel *ctx = &spanel->base;
+	ktime_t start;
+
+	mutex_lock(&ctx->mode_lock);
+	if (ctx->hbm.local_hbm.gamma_para_ready)
+		goto out;
+
+	if (!ctx->enabled || !ctx->current_mode ||
+	    ctx->current_mode->exynos_mode.is_lp_mode) {
+		spanel->lhbm.gamma_pending = true;
+		goto out;
+	}
+
+	start = ktime_get();
+	if (!s6e3fc3_6a_lhbm_gamma_read(ctx)) {
+		s6e3fc3_6a_lhbm_gamma_write(ctx);
+		spanel->lhbm.gamma_source = "panel";
+		spanel->lhbm.gamma_read_us = ktime_us_delta(ktime_get(), start);
+		dev_info(ctx->dev, "LHBM gamma read back in %uus\n",
+			 spanel->lhbm.gamma_read_us);
+	}
+out:
+	mutex_unlock(&ctx->mode_lock);
+}
+
+#define s6e3fc3_6a_DSC_BPP		8
+#define s6e3fc3_6a_DSC_LINE_BUF_DEPTH	9
+#define s6e3fc3_6a_DSC_INITIAL_XMIT_DELAY	512
+#define s6e3fc3_6a_DSC_INITIAL_OFFSET	6144
+#define s6e3fc3_6a_DSC_FIRST_LINE_BPG	12
+#define s6e3fc3_6a_DSC_INITIAL_SCALE	32
+
+#define s6e3fc3_6a_RC_RANGE(min_qp, max_qp, bpg_offset) \
+	{ (min_qp), (max_qp), (bpg_offset) & 0x3F }
+
+/* rate control for 8 bpc at 8 bpp, DSC 1.1 */
+static const u16 s6e3fc3_6a_rc_buf_thresh[DSC_NUM_BUF_RANGES - 1] = {
+	896, 1792, 2688, 3584, 4480, 5376, 6272,
+	6720, 7168, 7616, 7744, 7872, 8000, 8064
+};
+
+static const struct drm_dsc_rc_range_parameters
+s6e3fc3_6a_rc_range_params[DSC_NUM_BUF_RANGES] = {
+	s6e3fc3_6a_RC_RANGE(0, 4, 2),
+	s6e3fc3_6a_RC_RANGE(0, 4, 0),
+	s6e3fc3_6a_RC_RANGE(1, 5, 0),
+	s6e3fc3_6a_RC_RANGE(1, 6, -2),
+	s6e3fc3_6a_RC_RANGE(3, 7, -4),
+	s6e3fc3_6a_RC_RANGE(3, 7, -6),
+	s6e3fc3_6a_RC_RANGE(3, 7, -8),
+	s6e3fc3_6a_RC_RANGE(3, 8, -8),
+	s6e3fc3_6a_RC_RANGE(3, 9, -8),
+	s6e3fc3_6a_RC_RANGE(3, 10, -10),
+	s6e3fc3_6a_RC_RANGE(5, 11, -10),
+	s6e3fc3_6a_RC_RANGE(5, 12, -12),
+	s6e3fc3_6a_RC_RANGE(5, 13, -12),
+	s6e3fc3_6a_RC_RANGE(7, 13, -12),
+	s6e3fc3_6a_RC_RANGE(13, 15, -12),
+};
+
+static int s6e3fc3_6a_pps_generate(struct device *dev,
+				   const struct exynos_panel_mode *pmode,
+				   struct s6e3fc3_6a_pps *out)
+{
+	const struct drm_display_mode *mode = &pmode->mode;
+	const u32 slice_count = pmode->exynos_mode.dsc.slice_count;
+	const u32 slice_height = pmode->exynos_mode.dsc.slice_height;
+	struct drm_dsc_config cfg = {
+		.dsc_version_major = 1,
+		.dsc_version_minor = 1,
+		.bits_per_component = pmode->exynos_mode.bpc,
+		.bits_per_pixel = s6e3fc3_6a_DSC_BPP << 4,
+		.line_buf_depth = s6e3fc3_6a_DSC_LINE_BUF_DEPTH,
+		.block_pred_enable = true,
+		.convert_rgb = true,
+		.pic_width = mode->hdisplay,
+		.pic_height = mode->vdisplay,
+		.slice_count = slice_count,
+		.slice_height = slice_height,
+		.mux_word_size = DSC_MUX_WORD_SIZE_8_10_BPC,
+		.rc_model_size = DSC_RC_MODEL_SIZE_CONST,
+		.rc_edge_factor = DSC_RC_EDGE_FACTOR_CONST,
+		.rc_tgt_offset_high = DSC_RC_TGT_OFFSET_HI_CONST,
+		.rc_tgt_offset_low = DSC_RC_TGT_OFFSET_LO_CONST,
+		.rc_quant_incr_limit0 = 11,
+		.rc_quant_incr_limit1 = 11,
+		.flatness_min_qp = 3,
+		.flatness_max_qp = 12,
+		.initial_xmit_delay = s6e3fc3_6a_DSC_INITIAL_XMIT_DELAY,
+		.initial_offset = s6e3fc3_6a_DSC_INITIAL_OFFSET,
+		.first_line_bpg_offset = s6e3fc3_6a_DSC_FIRST_LINE_BPG,
+		.initial_scale_value = s6e3fc3_6a_DSC_INITIAL_SCALE,
+	};
+	int ret;
+
+	if (!pmode->exynos_mode.dsc.enabled)
+		return -EINVAL;
+
+	if (!slice_count || !slice_height || mode->hdisplay % slice_count ||
+	    mode->vdisplay % slice_height) {
+		dev_err(dev, "%ux%u can't be split in %u slices of height %u\n",
+			mode->hdisplay, mode->vdisplay, slice_count, slice_height);
+		return -EINVAL;
+	}
+	cfg.slice_width = mode->hdisplay / slice_count;
+
+	memcpy(cfg.rc_buf_thresh, s6e3fc3_6a_rc_buf_thresh, sizeof(cfg.rc_buf_thresh));
+	memcpy(cfg.rc_range_params, s6e3fc3_6a_rc_range_params,
+	       sizeof(cfg.rc_range_params));
+
+	ret = drm_dsc_compute_rc_parameters(&cfg);
+	if (ret) {
+		dev_err(dev, "failed to compute DSC rc parameters (%d)\n", ret);
+		return ret;
+	}
+
+	drm_dsc_pps_payload_pack(&out->pps, &cfg);
+	out->pmode = pmode;
+	out->chunk_size = cfg.slice_chunk_size;
+
+	return 0;
+}
+
+/*
+ * The vendor PPS only describes one slice geometry, it is compared against the
+ * generated PPS of the modes sharing that geometry. A mismatch means the
+ * generator can't be trusted for the other geometries either.
+ */
+static int s6e3fc3_6a_pps_check(struct device *dev,
+				const struct exynos_panel_desc *desc,
+				const struct s6e3fc3_6a_pps *pps)
+{
+	const struct drm_dsc_picture_parameter_set *ref = (const void *)desc->dsc_pps;
+
+	if (desc->dsc_pps_len != sizeof(*ref) ||
+	    ref->pic_width != pps->pps.pic_width ||
+	    ref->pic_height != pps->pps.pic_height ||
+	    ref->slice_width != pps->pps.slice_width ||
+	    ref->slice_height != pps->pps.slice_height)
+		return 0;
+
+	if (memcmp(ref, &pps->pps, sizeof(*ref))) {
+		dev_err(dev, "generated PPS for %ux%u@%d differs from vendor PPS\n",
+			pps->pmode->mode.hdisplay, pps->pmode->mode.vdisplay,
+			drm_mode_vrefresh(&pps->pmode->mode));
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int s6e3fc3_6a_pps_init(struct device *dev, struct s6e3fc3_6a_panel *spanel,
+			       const struct exynos_panel_desc *desc)
+{
+	const int num_pps = desc->num_modes + (desc->lp_mode ? 1 : 0);
+	int i, ret;
+
+	spanel->pps = devm_kcalloc(dev, num_pps, sizeof(*spanel->pps), GFP_KERNEL);
+	if (!spanel->pps)
+		return -ENOMEM;
+
+	for (i = 0; i < num_pps; i++) {
+		const struct exynos_panel_mode *pmode =
+			i < desc->num_modes ? &desc->modes[i] : desc->lp_mode;
+
+		ret = s6e3fc3_6a_pps_generate(dev, pmode, &spanel->pps[i]);
+		if (ret)
+			return ret;
+		ret = s6e3fc3_6a_pps_check(dev, desc, &spanel->pps[i]);
+		if (ret)
+			return ret;
+	}
+	spanel->num_pps = num_pps;
+
+	return 0;
+}
+
+static const struct s6e3fc3_6a_pps *
+s6e3fc3_6a_get_pps(struct exynos_panel *ctx, const struct exynos_panel_mode *pmode)
+{
+	struct s6e3fc3_6a_panel *spanel = to_spanel(ctx);
+	int i;
+
+	for (i = 0; i < spanel->num_pps; i++)
+		if (spanel->pps[i].pmode == pmode)
+			return &spanel->pps[i];
+
+	return NULL;
+}
+
+static void s6e3fc3_6a_pps_write(struct exynos_panel *ctx,
+				 const struct exynos_panel_mode *pmode)
+{
+	struct mipi_dsi_device *dsi = to_mipi_dsi_device(ctx->dev);
+	const struct s6e3fc3_6a_pps *pps = s6e3fc3_6a_get_pps(ctx, pmode);
+	int ret;
+
+	if (!pps) {
+		EXYNOS_PPS_LONG_WRITE(ctx); /* PPS_SETTING */
+		return;
+	}
+
+	ret = mipi_dsi_picture_parameter_set(dsi, &pps->pps);
+	to_spanel(ctx)->io_stats.tx_count++;
+	to_spanel(ctx)->io_stats.tx_bytes += sizeof(pps->pps);
+	if (ret < 0)
+		dev_err(ctx->dev, "failed to write PPS (%d)\n", ret);
+}
+
+static void s6e3fc3_6a_enable_stage_done(struct exynos_panel *ctx,
+					 enum s6e3fc3_6a_enable_stage stage)
+{
+	struct s6e3fc3_6a_panel *spanel = to_spanel(ctx);
+
+	spanel->enable_stage_us[stage] =
+		ktime_us_delta(ktime_get(), spanel->enable_start);
+}
+
+static int s6e3fc3_6a_enable(struct drm_panel *panel)
+{
+	struct exynos_panel *ctx = container_of(panel, struct exynos_panel, panel);
+	struct s6e3fc3_6a_panel *spanel = to_spanel(ctx);
+	const struct exynos_panel_mode *pmode = ctx->current_mode;
+	const struct drm_display_mode *mode;
+
+	if (!pmode) {
+		dev_err(ctx->dev, "no current mode set\n");
+		return -EINVAL;
+	}
+	mode = &pmode->mode;
+
+	dev_dbg(ctx->dev, "%s\n", __func__);
+
+	spanel->enable_start = ktime_get();
+	memset(spanel->enable_stage_us, 0, sizeof(spanel->enable_stage_us));
+
+	/* registers go back to their defaults on reset */
+	s6e3fc3_6a_shadow_invalidate(ctx, ~0);
+	exynos_panel_reset(ctx);
+	s6e3fc3_6a_enable_stage_done(ctx, s6e3fc3_6a_STAGE_RESET);
+
+	s6e3fc3_6a_DCS_BUF_ADD_AND_FLUSH(ctx, 0x11); /* sleep out */
+	s6e3fc3_6a_enable_stage_done(ctx, s6e3fc3_6a_STAGE_SLEEP_OUT);
+	s6e3fc3_6a_usleep(ctx, s6e3fc3_6a_SLEEP_OUT_DELAY_MS * 1000,
+			  s6e3fc3_6a_SLEEP_OUT_DELAY_MS * 1000 + 10);
+	s6e3fc3_6a_enable_stage_done(ctx, s6e3fc3_6a_STAGE_SLEEP_OUT_DONE);
+
+	s6e3fc3_6a_send_cmd_set_batched(ctx, &s6e3fc3_6a_init_cmd_set);
+	s6e3fc3_6a_enable_stage_done(ctx, s6e3fc3_6a_STAGE_INIT);
+
+	spanel->idle.vrefresh = drm_mode_vrefresh(mode);
+	spanel->idle.active = false;
+	s6e3fc3_6a_change_frequency(ctx, spanel->idle.vrefresh);
+	s6e3fc3_6a_enable_stage_done(ctx, s6e3fc3_6a_STAGE_FREQ);
+
+	if (ctx->panel_rev == PANEL_REV_PROTO1_1) {
+		s6e3fc3_6a_send_cmd_set_batched(ctx, &s6e3fc3_6a_4_pwm_cmd_set);
+	} else if (ctx->panel_rev >= PANEL_REV_EVT1_1 &&
+		   ctx->hbm.local_hbm.gamma_para_ready) {
+		s6e3fc3_6a_lhbm_gamma_write(ctx);
+		s6e3fc3_6a_enable_stage_done(ctx, s6e3fc3_6a_STAGE_LHBM_GAMMA);
+	}
+
+	/* DSC related configuration */
+	exynos_dcs_compression_mode(ctx, 0x1); /* DSC_DEC_ON */
+	s6e3fc3_6a_pps_write(ctx, pmode);
+	s6e3fc3_6a_DCS_BUF_ADD(ctx, 0xC2, 0x14); /* PPS_MIC_OFF */
+	s6e3fc3_6a_DCS_BUF_ADD_AND_FLUSH(ctx, 0x9D, 0x01); /* PPS_DSC_EN */
+	s6e3fc3_6a_enable_stage_done(ctx, s6e3fc3_6a_STAGE_PPS);
+
+	s6e3fc3_6a_update_wrctrld(ctx); /* dimming and HBM */
+	s6e3fc3_6a_enable_stage_done(ctx, s6e3fc3_6a_STAGE_WRCTRLD);
+
+	ctx->enabled = true;
+
+	if (pmode->exynos_mode.is_lp_mode)
+		s6e3fc3_6a_set_lp_mode(ctx, pmode);
+	else
+		s6e3fc3_6a_DCS_BUF_ADD_AND_FLUSH(ctx, 0x29); /* display on */
+	s6e3fc3_6a_enable_stage_done(ctx, s6e3fc3_6a_STAGE_DISPLAY_ON);
+
+	s6e3fc3_6a_op_done(ctx, s6e3fc3_6a_OP_ENABLE, spanel->enable_start);
+
+	/* a reset by the watchdog reschedules it once the recovery is checked */
+	if (!spanel->esd.busy) {
+		spanel->esd.retries = 0;
+		spanel->esd.tx_errors = spanel->io_stats.tx_errors;
+		if (spanel->esd.period_ms)
+			mod_delayed_work(system_wq, &spanel->esd.work,
+					 msecs_to_jiffies(spanel->esd.period_ms));
+	}
+
+	return 0;
+}
+
+static int s6e3fc3_6a_disable(struct drm_panel *panel)
+{
+	struct exynos_panel *ctx = container_of(panel, struct exynos_panel, panel);
+
+	s6e3fc3_6a_idle_stop(ctx);
+	s6e3fc3_6a_freq_stats_update(ctx, 0);
+	s6e3fc3_6a_aod_lp_stop(ctx);
+	to_spanel(ctx)->te_stats.last_pmode = NULL;
+	s6e3fc3_6a_power_stats_update(ctx);
+
+	/* enable programs the state from scratch */
+	to_spanel(ctx)->state.pending = 0;
+	cancel_delayed_work(&to_spanel(ctx)->state.flush_work);
+
+	/* the work rechecks the panel state under mode_lock, no need to sync */
+	cancel_delayed_work(&to_spanel(ctx)->esd.work);
+
+	/* off commands send sleep in, nothing in the cache survives it */
+	s6e3fc3_6a_shadow_invalidate(ctx, ~0);
+
+	return exynos_panel_disable(panel);
+}
+
+static void s6e3fc3_6a_apply_hbm_mode(struct exynos_panel *exynos_panel,
+				      enum exynos_hbm_mode mode, bool defer)
+{
+	struct s6e3fc3_6a_panel *spanel = to_spanel(exynos_panel);
+	const bool hbm_update =
+		(IS_HBM_ON(exynos_panel->hbm_mode) != IS_HBM_ON(mode));
+	const bool irc_update =
+		(IS_HBM_ON_IRC_OFF(exynos_panel->hbm_mode) != IS_HBM_ON_IRC_OFF(mode));
+	ktime_t start = ktime_get();
+	u32 changes = 0;
+
+	exynos_panel->hbm_mode = mode;
+
+	if (hbm_update)
+		changes |= s6e3fc3_6a_STATE_PWM | s6e3fc3_6a_STATE_WRCTRLD;
+	if (irc_update)
+		changes |= s6e3fc3_6a_STATE_IRC;
+	if (defer) {
+		s6e3fc3_6a_state_commit(exynos_panel, changes);
+	} else {
+		spanel->state.pending |= changes;
+		s6e3fc3_6a_state_flush(exynos_panel, false);
+	}
+	s6e3fc3_6a_power_stats_update(exynos_panel);
+	s6e3fc3_6a_op_done(exynos_panel, s6e3fc3_6a_OP_HBM, start);
+	dev_info(exynos_panel->dev, "hbm_on=%d hbm_ircoff=%d\n", IS_HBM_ON(exynos_panel->hbm_mode),
+		 IS_HBM_ON_IRC_OFF(exynos_panel->hbm_mode));
+}
+
+/* applies @mode within the thermal limits without recording it as requested */
+static void s6e3fc3_6a_limit_hbm_mode(struct exynos_panel *exynos_panel,
+				      enum exynos_hbm_mode mode, bool defer)
+{
+	if (to_spanel(exynos_panel)->thermal.state >= s6e3fc3_6a_THERMAL_NO_HBM)
+		mode = HBM_OFF;
+
+	s6e3fc3_6a_apply_hbm_mode(exynos_panel, mode, defer);
+}
+
+static void s6e3fc3_6a_request_hbm_mode(struct exynos_panel *exynos_panel,
+					enum exynos_hbm_mode mode, bool defer)
+{
+	to_spanel(exynos_panel)->thermal.hbm_req = mode;
+	s6e3fc3_6a_limit_hbm_mode(exynos_panel, mode, defer);
+}
+
+static void s6e3fc3_6a_set_hbm_mode(struct exynos_panel *exynos_panel,
+				enum exynos_hbm_mode mode)
+{
+	s6e3fc3_6a_request_hbm_mode(exynos_panel, mode, true);
+}
+
+/* records @br, capped by the thermal state, to be sent with the pending state */
+static void s6e3fc3_6a_defer_brightness(struct exynos_panel *ctx, u16 br)
+{
+	struct s6e3fc3_6a_panel *spanel = to_spanel(ctx);
+	const unsigned long state = spanel->thermal.state;
+
+	if (state >= s6e3fc3_6a_THERMAL_NO_HBM)
+		br = min_t(u16, br, ctx->desc->brt_capability->normal.level.max);
+	else if (state >= s6e3fc3_6a_THERMAL_HBM_CAP_STATE)
+		br = min_t(u16, br, s6e3fc3_6a_THERMAL_HBM_CAP);
+
+	spanel->state.brightness = br;
+	spanel->state.pending |= s6e3fc3_6a_STATE_BRIGHTNESS;
+}
+
+static int s6e3fc3_6a_set_brightness(struct exynos_panel *ctx, u16 br)
+{
+	ktime_t start = ktime_get();
+
+	/* binned LP modes are picked by the common driver */
+	if (ctx->current_mode && ctx->current_mode->exynos_mode.is_lp_mode)
+		return exynos_panel_set_brightness(ctx, br);
+
+	s6e3fc3_6a_defer_brightness(ctx, br);
+	s6e3fc3_6a_state_commit(ctx, 0);
+	s6e3fc3_6a_op_done(ctx, s6e3fc3_6a_OP_BRIGHTNESS, start);
+
+	return 0;
+}
+
+static bool s6e3fc3_6a_esd_te_alive(struct exynos_panel *ctx, u32 period_us)
+{
+	struct drm_crtc *crtc = s6e3fc3_6a_get_crtc(ctx);
+	const u32 wait_us = s6e3fc3_6a_ESD_TE_PERIODS * period_us;
+	u64 count;
+	bool alive;
+
+	/* vblank is off along with the crtc, TE cannot be checked then */
+	if (!crtc || drm_crtc_vblank_get(crtc))
+		return true;
+
+	count = drm_crtc_vblank_count(crtc);
+	usleep_range(wait_us, wait_us + 1000);
+	alive = drm_crtc_vblank_count(crtc) != count;
+	drm_crtc_vblank_put(crtc);
+
+	return alive;
+}
+
+/*
+ * Power mode bits of s6e3fc3_6a_ESD_POWER_MODE the panel must report, @mask is
+ * narrowed to the bits whose state is known.
+ */
+static u8 s6e3fc3_6a_esd_power_mode(struct exynos_panel *ctx, u8 *mask)
+{
+	const int bin = to_spanel(ctx)->aod.bin;
+
+	*mask = s6e3fc3_6a_ESD_POWER_MODE;
+	if (!ctx->current_mode->exynos_mode.is_lp_mode)
+		return s6e3fc3_6a_ESD_POWER_MODE;
+
+	/* LP entry and the "off" bin send display off, the other bins display on */
+	if (bin < 0)
+		*mask = MIPI_DCS_POWER_MODE_SLEEP_MODE;
+	else if (bin == 0)
+		return MIPI_DCS_POWER_MODE_SLEEP_MODE;
+
+	return s6e3fc3_6a_ESD_POWER_MODE;
+}
+
+static enum s6e3fc3_6a_esd_fault s6e3fc3_6a_esd_check(struct exynos_panel *ctx)
+{
+	struct s6e3fc3_6a_panel *spanel = to_spanel(ctx);
+	struct s6e3fc3_6a_esd *esd = &spanel->esd;
+	enum s6e3fc3_6a_esd_fault fault = s6e3fc3_6a_ESD_NONE;
+	u32 period_us = 0;
+	u8 mode, expected, mask;
+	int ret;
+
+	mutex_lock(&ctx->mode_lock);
+	if (!ctx->enabled || !ctx->current_mode)
+		goto out;
+
+	if (esd->inject != s6e3fc3_6a_ESD_NONE) {
+		fault = esd->inject;
+		esd->inject = s6e3fc3_6a_ESD_NONE;
+		goto out;
+	}
+
+	if (spanel->io_stats.tx_errors != esd->tx_errors) {
+		esd->tx_errors = spanel->io_stats.tx_errors;
+		fault = s6e3fc3_6a_ESD_TX_ERROR;
+		goto out;
+	}
+
+	expected = s6e3fc3_6a_esd_power_mode(ctx, &mask);
+	ret = s6e3fc3_6a_dcs_read(ctx, MIPI_DCS_GET_POWER_MODE, &mode, 1);
+	if (ret != 1)
+		fault = s6e3fc3_6a_ESD_READ_ERROR;
+	else if ((mode & mask) != expected)
+		fault = s6e3fc3_6a_ESD_STATUS;
+	else if (!ctx->current_mode->exynos_mode.is_lp_mode)
+		period_us = s6e3fc3_6a_te_period_us(ctx);
+out:
+	mutex_unlock(&ctx->mode_lock);
+
+	/* commits must not wait behind mode_lock while TE is checked */
+	if (period_us && !s6e3fc3_6a_esd_te_alive(ctx, period_us))
+		fault = s6e3fc3_6a_ESD_TE_LOST;
+
+	return fault;
+}
+
+/* first tier: re-send the registers the driver keeps state for */
+static void s6e3fc3_6a_esd_restore(struct exynos_panel *ctx)
+{
+	struct s6e3fc3_6a_panel *spanel = to_spanel(ctx);
+	struct s6e3fc3_6a_state *st = &spanel->state;
+
+	s6e3fc3_6a_shadow_invalidate(ctx, ~0);
+
+	if (ctx->panel_rev >= PANEL_REV_EVT1_1 && ctx->hbm.local_hbm.gamma_para_ready)
+		s6e3fc3_6a_lhbm_gamma_write(ctx);
+	s6e3fc3_6a_update_te2(ctx);
+
+	/* a refresh rate change waiting for commit_done wins over the current one */
+	if (!(st->pending & s6e3fc3_6a_STATE_FREQ))
+		st->vrefresh = spanel->freq_stats.vrefresh;
+	st->pending |= s6e3fc3_6a_STATE_PWM | s6e3fc3_6a_STATE_IRC |
+		       s6e3fc3_6a_STATE_WRCTRLD | s6e3fc3_6a_STATE_FREQ;
+	if (ctx->bl)
+		s6e3fc3_6a_defer_brightness(ctx, ctx->bl->props.brightness);
+	s6e3fc3_6a_state_flush(ctx, false);
+	s6e3fc3_6a_DCS_BUF_ADD_TABLE_AND_FLUSH(ctx, display_on);
+}
+
+/*
+ * Last tier: power cycle the panel through the DRM panel callbacks, off
+ * sequence and regulators included, then restore what enable doesn't program.
+ */
+static void s6e3fc3_6a_esd_reset(struct exynos_panel *ctx)
+{
+	struct s6e3fc3_6a_panel *spanel = to_spanel(ctx);
+	const enum exynos_hbm_mode hbm_mode = ctx->hbm_mode;
+	const bool dimming_on = ctx->dimming_on;
+	int ret;
+
+	drm_panel_disable(&ctx->panel);
+	drm_panel_unprepare(&ctx->panel);
+	ret = drm_panel_prepare(&ctx->panel);
+	if (ret) {
+		dev_err(ctx->dev, "failed to power the panel back on (%d)\n", ret);
+		return;
+	}
+
+	/* disable forgets the HBM and dimming state enable programs from */
+	ctx->hbm_mode = hbm_mode;
+	ctx->dimming_on = dimming_on;
+	drm_panel_enable(&ctx->panel);
+	if (!ctx->enabled || ctx->current_mode->exynos_mode.is_lp_mode)
+		return;
+
+	/* enable leaves HBM PWM and IRC at their defaults */
+	spanel->state.pending |= s6e3fc3_6a_STATE_PWM | s6e3fc3_6a_STATE_IRC;
+	if (ctx->bl)
+		s6e3fc3_6a_defer_brightness(ctx, ctx->bl->props.brightness);
+	s6e3fc3_6a_state_flush(ctx, false);
+	s6e3fc3_6a_power_stats_update(ctx);
+}
+
+static void s6e3fc3_6a_esd_recover(struct exynos_panel *ctx,
+				   enum s6e3fc3_6a_esd_fault fault)
+{
+	struct s6e3fc3_6a_esd *esd = &to_spanel(ctx)->esd;
+	ktime_t start = ktime_get();
+	bool restore;
+
+	mutex_lock(&ctx->mode_lock);
+	if (!ctx->enabled || !ctx->current_mode) {
+		mutex_unlock(&ctx->mode_lock);
+		return;
+	}
+	esd->faults[fault]++;
+	esd->busy = true;
+	/* LP registers belong to the LP command set, only a reset restores them */
+	restore = !ctx->current_mode->exynos_mode.is_lp_mode;
+	dev_warn(ctx->dev, "%s detected, %s panel\n", s6e3fc3_6a_esd_fault_names[fault],
+		 restore ? "restoring" : "resetting");
+	if (restore)
+		s6e3fc3_6a_esd_restore(ctx);
+	mutex_unlock(&ctx->mode_lock);
+
+	if (restore) {
+		fault = s6e3fc3_6a_esd_check(ctx);
+		if (fault == s6e3fc3_6a_ESD_NONE) {
+			mutex_lock(&ctx->mode_lock);
+			s6e3fc3_6a_op_done(ctx, s6e3fc3_6a_OP_ESD_RESTORE, start);
+			esd->restored++;
+			goto done;
+		}
+		dev_warn(ctx->dev, "%s after restore, resetting panel\n",
+			 s6e3fc3_6a_esd_fault_names[fault]);
+	}
+
+	mutex_lock(&ctx->mode_lock);
+	if (ctx->enabled)
+		s6e3fc3_6a_esd_reset(ctx);
+	mutex_unlock(&ctx->mode_lock);
+
+	fault = s6e3fc3_6a_esd_check(ctx);
+	mutex_lock(&ctx->mode_lock);
+	if (fault == s6e3fc3_6a_ESD_NONE) {
+		s6e3fc3_6a_op_done(ctx, s6e3fc3_6a_OP_ESD_RESET, start);
+		esd->resets++;
+		goto done;
+	}
+
+	esd->failed++;
+	if (++esd->retries >= s6e3fc3_6a_ESD_MAX_RETRIES)
+		dev_err(ctx->dev, "%s after reset, giving up until next enable\n",
+			s6e3fc3_6a_esd_fault_names[fault]);
+	esd->busy = false;
+	mutex_unlock(&ctx->mode_lock);
+	return;
+
+done:
+	esd->retries = 0;
+	esd->busy = false;
+	mutex_unlock(&ctx->mode_lock);
+	dev_info(ctx->dev, "panel recovered in %lldus\n", ktime_us_delta(ktime_get(), start));
+}
+
+static void s6e3fc3_6a_esd_work(struct work_struct *work)
+{
+	struct s6e3fc3_6a_panel *spanel = container_of(to_delayed_work(work),
+						       struct s6e3fc3_6a_panel, esd.work);
+	struct exynos_panel *ctx = &spanel->base;
+	struct s6e3fc3_6a_esd *esd = &spanel->esd;
+	enum s6e3fc3_6a_esd_fault fault;
+
+	fault = s6e3fc3_6a_esd_check(ctx);
+	if (fault != s6e3fc3_6a_ESD_NONE)
+		s6e3fc3_6a_esd_recover(ctx, fault);
+
+	mutex_lock(&ctx->mode_lock);
+	if (ctx->enabled && esd->period_ms && esd->retries < s6e3fc3_6a_ESD_MAX_RETRIES)
+		mod_delayed_work(system_wq, &esd->work, msecs_to_jiffies(esd->period_ms));
+	mutex_unlock(&ctx->mode_lock);
+}
+
+static void s6e3fc3_6a_set_dimming_on(struct exynos_panel *exynos_panel,
+				 bool dimming_on)
+{
+	exynos_panel->dimming_on = dimming_on;
+
+	s6e3fc3_6a_state_commit(exynos_panel, s6e3fc3_6a_STATE_WRCTRLD);
+	s6e3fc3_6a_power_stats_update(exynos_panel);
+}
+
+static void s6e3fc3_6a_lhbm_latency_work(struct work_struct *work)
+{
+	struct s6e3fc3_6a_panel *spanel =
+		container_of(work, struct s6e3fc3_6a_panel, lhbm.latency_work);
+	struct exynos_panel *ctx = &spanel->base;
+	struct s6e3fc3_6a_lhbm *lhbm = &spanel->lhbm;
+	struct drm_crtc *crtc = s6e3fc3_6a_get_crtc(ctx);
+	bool te_seen = false;
+	bool enabled;
+	ktime_t ts;
+	u64 count;
+	int i;
+
+	if (!crtc)
+		return;
+
+	/* the first TE after the command latches it, the next one shows it */
+	for (i = 0; i < 4; i++) {
+		/* no TE comes once the panel is off, drop the sample */
+		mutex_lock(&ctx->mode_lock);
+		enabled = ctx->enabled;
+		mutex_unlock(&ctx->mode_lock);
+		if (!enabled)
+			return;
+
+		count = drm_crtc_vblank_count_and_time(crtc, &ts);
+		if (count == lhbm->sent_vblank + 1 && !te_seen) {
+			s6e3fc3_6a_hist_add(&lhbm->to_te,
+					    ktime_us_delta(ts, lhbm->request_ts));
+			te_seen = true;
+		}
+		if (count >= lhbm->sent_vblank + 2) {
+			s6e3fc3_6a_hist_add(&lhbm->to_frame,
+					    ktime_us_delta(ts, lhbm->request_ts));
+			return;
+		}
+		if (!s6e3fc3_6a_wait_one_vblank(ctx))
+			return;
+	}
+}
+
+/*
+ * Local HBM is on the fingerprint unlock path: send the WRCTRLD write right
+ * away instead of waiting for commit_done, and if the next TE is too close to
+ * be sure it is latched there, wait for that TE to pass so the circle shows up
+ * exactly one frame later.
+ */
+static void s6e3fc3_6a_lhbm_on(struct exynos_panel *ctx)
+{
+	struct s6e3fc3_6a_lhbm *lhbm = &to_spanel(ctx)->lhbm;
+	struct drm_crtc *crtc = s6e3fc3_6a_get_crtc(ctx);
+
+	lhbm->request_ts = ktime_get();
+	s6e3fc3_6a_te_guard(ctx, lhbm->request_ts);
+
+	if (crtc)
+		lhbm->sent_vblank = drm_crtc_vblank_count(crtc);
+
+	/* changes pending from the commit go out in the same burst */
+	to_spanel(ctx)->state.pending |= s6e3fc3_6a_STATE_WRCTRLD;
+	s6e3fc3_6a_state_flush(ctx, false);
+
+	if (crtc)
+		queue_work(system_highpri_wq, &lhbm->latency_work);
+}
+
+static void s6e3fc3_6a_set_local_hbm_mode(struct exynos_panel *exynos_panel,
+				 bool local_hbm_en)
+{
+	if (exynos_panel->hbm.local_hbm.enabled == local_hbm_en)
+		return;
+
+	exynos_panel->hbm.local_hbm.enabled = local_hbm_en;
+	if (local_hbm_en) {
+		s6e3fc3_6a_lhbm_on(exynos_panel);
+	} else {
+		to_spanel(exynos_panel)->state.pending |= s6e3fc3_6a_STATE_WRCTRLD;
+		s6e3fc3_6a_state_flush(exynos_panel, false);
+	}
+	s6e3fc3_6a_power_stats_update(exynos_panel);
+}
+
+static int s6e3fc3_6a_bl_lut_init(struct exynos_panel *ctx)
+{
+	struct s6e3fc3_6a_bl_transition *tr = &to_spanel(ctx)->bl_transition;
+	const struct brightness_capability *cap = ctx->desc->brt_capability;
+	u32 level;
+
+	if (!cap)
+		return -EINVAL;
+
+	tr->lut_len = ctx->desc->max_brightness + 1;
+	tr->lut = devm_kcalloc(ctx->dev, tr->lut_len, sizeof(*tr->lut), GFP_KERNEL);
+	if (!tr->lut)
+		return -ENOMEM;
+
+	for (level = 1; level < tr->lut_len; level++) {
+		const typeof(cap->normal) *range =
+			level <= cap->normal.level.max ? &cap->normal : &cap->hbm;
+		u32 lvl = clamp_t(u32, level, range->level.min, range->level.max);
+
+		tr->lut[level] = range->nits.min * 1000 +
+			mult_frac((range->nits.max - range->nits.min) * 1000,
+				  lvl - range->level.min,
+				  range->level.max - range->level.min);
+	}
+
+	return 0;
+}
+
+/* lowest brightness level reaching @millinits */
+static u16 s6e3fc3_6a_bl_lut_level(const struct s6e3fc3_6a_bl_transition *tr,
+				   u32 millinits)
+{
+	u32 lo = 0, hi = tr->lut_len - 1;
+
+	while (lo < hi) {
+		u32 mid = (lo + hi) / 2;
+
+		if (tr->lut[mid] < millinits)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+static void s6e3fc3_6a_bl_transition_work(struct work_struct *work)
+{
+	struct s6e3fc3_6a_panel *spanel =
+		container_of(work, struct s6e3fc3_6a_panel, bl_transition.work);
+	struct s6e3fc3_6a_bl_transition *tr = &spanel->bl_transition;
+	struct exynos_panel *ctx = &spanel->base;
+	const u16 hbm_min = ctx->desc->brt_capability->hbm.level.min;
+	u32 t, from_mnits, to_mnits;
+	bool enabled;
+	s64 mnits;
+	u16 level;
+
+	for (;;) {
+		mutex_lock(&ctx->mode_lock);
+		enabled = ctx->enabled;
+		if (!enabled)
+			tr->active = false;
+		mutex_unlock(&ctx->mode_lock);
+		if (!enabled)
+			break;
+
+		if (!s6e3fc3_6a_wait_one_vblank(ctx))
+			usleep_range(16000, 16010);
+
+		mutex_lock(&ctx->mode_lock);
+		if (!ctx->enabled || !ctx->bl || !ctx->current_mode ||
+		    ctx->current_mode->exynos_mode.is_lp_mode) {
+			tr->active = false;
+			mutex_unlock(&ctx->mode_lock);
+			break;
+		}
+
+		t = s6e3fc3_6a_BL_TRANSITION_ONE;
+		if (tr->duration_ms)
+			t = min_t(u64, t, div_u64((u64)ktime_ms_delta(ktime_get(), tr->start) *
+						 s6e3fc3_6a_BL_TRANSITION_ONE,
+						 tr->duration_ms));
+		if (tr->curve == s6e3fc3_6a_BL_CURVE_EASE)
+			t = t * t * (3 * s6e3fc3_6a_BL_TRANSITION_ONE - 2 * t) /
+			    (s6e3fc3_6a_BL_TRANSITION_ONE * s6e3fc3_6a_BL_TRANSITION_ONE);
+
+		from_mnits = tr->lut[tr->from];
+		to_mnits = tr->lut[tr->target];
+		mnits = from_mnits + div_s64(((s64)to_mnits - from_mnits) * t,
+					     s6e3fc3_6a_BL_TRANSITION_ONE);
+		level = (t == s6e3fc3_6a_BL_TRANSITION_ONE) ?
+			tr->target : s6e3fc3_6a_bl_lut_level(tr, mnits);
+		tr->steps++;
+
+		if (level != tr->level) {
+			/*
+			 * cross the normal/HBM boundary before writing an HBM level,
+			 * the mode userspace asked for stays in thermal.hbm_req
+			 */
+			if (level >= hbm_min && !IS_HBM_ON(ctx->hbm_mode))
+				s6e3fc3_6a_limit_hbm_mode(ctx, HBM_ON_IRC_ON, false);
+			else if (level < hbm_min && IS_HBM_ON(ctx->hbm_mode))
+				s6e3fc3_6a_limit_hbm_mode(ctx, HBM_OFF, false);
+
+			/* the ramp already runs one step per TE */
+			s6e3fc3_6a_defer_brightness(ctx, level);
+			s6e3fc3_6a_state_flush(ctx, true);
+			tr->level = level;
+			tr->writes++;
+		}
+		if (t == s6e3fc3_6a_BL_TRANSITION_ONE)
+			tr->active = false;
+		mutex_unlock(&ctx->mode_lock);
+
+		if (t == s6e3fc3_6a_BL_TRANSITION_ONE) {
+			/* publish the final level through the backlight core */
+			backlight_device_set_brightness(ctx->bl, level);
+			break;
+		}
+	}
+}
+
+static int s6e3fc3_6a_bl_transition_start(struct exynos_panel *ctx, u16 target,
+					  u32 duration_ms, enum s6e3fc3_6a_bl_curve curve)
+{
+	struct s6e3fc3_6a_bl_transition *tr = &to_spanel(ctx)->bl_transition;
+
+	if (!tr->lut || !ctx->bl || target >= tr->lut_len)
+		return -EINVAL;
+
+	mutex_lock(&ctx->mode_lock);
+	if (!ctx->enabled) {
+		mutex_unlock(&ctx->mode_lock);
+		return -EAGAIN;
+	}
+	/* a running ramp continues from the level it last wrote */
+	if (!tr->active)
+		tr->level = ctx->bl->props.brightness;
+	tr->from = tr->level;
+	tr->target = target;
+	tr->active = true;
+	tr->duration_ms = duration_ms;
+	tr->curve = curve;
+	tr->start = ktime_get();
+	tr->steps = 0;
+	tr->writes = 0;
+	mutex_unlock(&ctx->mode_lock);
+
+	/* a running ramp picks up the new parameters on its next step */
+	queue_work(system_highpri_wq, &tr->work);
+
+	return 0;
+}
+
+static ssize_t brightness_transition_show(struct device *dev,
+					  struct device_attribute *attr, char *buf)
+{
+	struct mipi_dsi_device *dsi = to_mipi_dsi_device(dev);
+	struct exynos_panel *ctx = mipi_dsi_get_drvdata(dsi);
+	struct s6e3fc3_6a_bl_transition *tr = &to_spanel(ctx)->bl_transition;
+
+	return scnprintf(buf, PAGE_SIZE, "%u %u %s steps=%u writes=%u\n",
+			 tr->target, tr->duration_ms,
+			 tr->curve == s6e3fc3_6a_BL_CURVE_EASE ? "ease" : "linear",
+			 tr->steps, tr->writes);
+}
+
+/* "<target level> <duration ms> [linear|ease]" */
+static ssize_t brightness_transition_store(struct device *dev,
+					   struct device_attribute *attr,
+					   const char *buf, size_t count)
+{
+	struct mipi_dsi_device *dsi = to_mipi_dsi_device(dev);
+	struct exynos_panel *ctx = mipi_dsi_get_drvdata(dsi);
+	enum s6e3fc3_6a_bl_curve curve = s6e3fc3_6a_BL_CURVE_LINEAR;
+	char curve_name[8] = "";
+	u32 target, duration_ms;
+	int ret;
+
+	if (sscanf(buf, "%u %u %7s", &target, &duration_ms, curve_name) < 2)
+		return -EINVAL;
+
+	if (!strcmp(curve_name, "ease"))
+		curve = s6e3fc3_6a_BL_CURVE_EASE;
+	else if (curve_name[0] && strcmp(curve_name, "linear"))
+		return -EINVAL;
+
+	if (target > U16_MAX)
+		return -EINVAL;
+
+	ret = s6e3fc3_6a_bl_transition_start(ctx, target, duration_ms, curve);
+
+	return ret ? ret : count;
+}
+static DEVICE_ATTR_RW(brightness_transition);
+
+static ssize_t power_state_stats_show(struct device *dev,
+				      struct device_attribute *attr, char *buf)
+{
+	struct mipi_dsi_device *dsi = to_mipi_dsi_device(dev);
+	struct exynos_panel *ctx = mipi_dsi_get_drvdata(dsi);
+	struct s6e3fc3_6a_power_stats *stats = &to_spanel(ctx)->power_stats;
+	ktime_t now = ktime_get();
+	ssize_t len = 0;
+	u64 ms;
+	int i, j;
+
+	mutex_lock(&ctx->mode_lock);
+
+	len += scnprintf(buf + len, PAGE_SIZE - len, "state: %s\n",
+			 s6e3fc3_6a_power_state_names[stats->state]);
+	for (i = 0; i < s6e3fc3_6a_PS_MAX; i++) {
+		ms = stats->ms[i];
+		if (i == stats->state)
+			ms += ktime_ms_delta(now, stats->since);
+		len += scnprintf(buf + len, PAGE_SIZE - len, "%s_ms: %llu\n",
+				 s6e3fc3_6a_power_state_names[i], ms);
+	}
+	ms = stats->dimming_ms;
+	if (stats->dimming_since)
+		ms += ktime_ms_delta(now, stats->dimming_since);
+	len += scnprintf(buf + len, PAGE_SIZE - len, "dimming_ms: %llu\n", ms);
+
+	/* one row per source state, one column per destination state */
+	len += scnprintf(buf + len, PAGE_SIZE - len, "transitions:\n");
+	for (i = 0; i < s6e3fc3_6a_PS_MAX; i++) {
+		len += scnprintf(buf + len, PAGE_SIZE - len, "%s:",
+				 s6e3fc3_6a_power_state_names[i]);
+		for (j = 0; j < s6e3fc3_6a_PS_MAX; j++)
+			len += scnprintf(buf + len, PAGE_SIZE - len, " %u",
+					 stats->transitions[i][j]);
+		len += scnprintf(buf + len, PAGE_SIZE - len, "\n");
+	}
+
+	len += scnprintf(buf + len, PAGE_SIZE - len, "updates: %u avg_ns: %llu\n",
+			 stats->updates,
+			 stats->updates ? div_u64(stats->update_ns, stats->updates) : 0);
+
+	mutex_unlock(&ctx->mode_lock);
+
+	return len;
+}
+
+/* any write clears the counters, the current state is kept */
+static ssize_t power_state_stats_store(struct device *dev,
+				       struct device_attribute *attr,
+				       const char *buf, size_t count)
+{
+	struct mipi_dsi_device *dsi = to_mipi_dsi_device(dev);
+	struct exynos_panel *ctx = mipi_dsi_get_drvdata(dsi);
+	struct s6e3fc3_6a_power_stats *stats = &to_spanel(ctx)->power_stats;
+	ktime_t now = ktime_get();
+
+	mutex_lock(&ctx->mode_lock);
+	memset(stats->ms, 0, sizeof(stats->ms));
+	memset(stats->transitions, 0, sizeof(stats->transitions));
+	stats->since = now;
+	stats->dimming_ms = 0;
+	if (stats->dimming_since)
+		stats->dimming_since = now;
+	stats->updates = 0;
+	stats->update_ns = 0;
+	mutex_unlock(&ctx->mode_lock);
+
+	return count;
+}
+static DEVICE_ATTR_RW(power_state_stats);
+
+/*
+ * Parses "<panel id> <gamma bytes in hex>" into @gamma, a blob saved from
+ * another panel must not be applied.
+ */
+static int s6e3fc3_6a_lhbm_gamma_parse(struct exynos_panel *ctx, const char *buf,
+				       u8 *gamma)
+{
+	const char *sep = strchr(buf, ' ');
+
+	if (!sep || sep - buf != strlen(ctx->panel_id) ||
+	    strncmp(buf, ctx->panel_id, sep - buf))
+		return -EINVAL;
+
+	if (hex2bin(gamma, skip_spaces(sep), s6e3fc3_6a_LOCAL_HBM_GAMMA_CMD_SIZE - 1))
+		return -EINVAL;
+
+	return 0;
+}
+
+static void s6e3fc3_6a_lhbm_gamma_restore(struct exynos_panel *ctx, const u8 *gamma)
+{
+	struct s6e3fc3_6a_panel *spanel = to_spanel(ctx);
+
+	ctx->hbm.local_hbm.gamma_cmd[0] = 0x65;
+	memcpy(ctx->hbm.local_hbm.gamma_cmd + 1, gamma,
+	       s6e3fc3_6a_LOCAL_HBM_GAMMA_CMD_SIZE - 1);
+	ctx->hbm.local_hbm.gamma_para_ready = true;
+	spanel->lhbm.gamma_pending = false;
+	spanel->lhbm.gamma_source = "cache";
+	/* the work finds the gamma ready, no need to wait for it */
+	cancel_delayed_work(&spanel->lhbm.gamma_work);
+}
+
+/*
+ * "<panel id> <gamma bytes in hex>", saved by userspace to skip the readback.
+ * The file exists from probe on, a blob written before the panel id is read
+ * is kept and checked against the id once the panel is initialized.
+ */
+static ssize_t lhbm_gamma_show(struct device *dev,
+			       struct device_attribute *attr, char *buf)
+{
+	struct mipi_dsi_device *dsi = to_mipi_dsi_device(dev);
+	struct exynos_panel *ctx = mipi_dsi_get_drvdata(dsi);
+	const u8 *gamma = ctx->hbm.local_hbm.gamma_cmd + 1;
+
+	if (!ctx->hbm.local_hbm.gamma_para_ready)
+		return -ENODATA;
+
+	return scnprintf(buf, PAGE_SIZE, "%s %*phN\n", ctx->panel_id,
+			 s6e3fc3_6a_LOCAL_HBM_GAMMA_CMD_SIZE - 1, gamma);
+}
+
+static ssize_t lhbm_gamma_store(struct device *dev,
+				struct device_attribute *attr,
+				const char *buf, size_t count)
+{
+	struct mipi_dsi_device *dsi = to_mipi_dsi_device(dev);
+	struct exynos_panel *ctx = mipi_dsi_get_drvdata(dsi);
+	struct s6e3fc3_6a_panel *spanel = to_spanel(ctx);
+	u8 gamma[s6e3fc3_6a_LOCAL_HBM_GAMMA_CMD_SIZE - 1];
+	int ret = 0;
+
+	if (count >= sizeof(spanel->lhbm.gamma_saved))
+		return -EINVAL;
+
+	mutex_lock(&ctx->mode_lock);
+	if (ctx->hbm.local_hbm.gamma_para_ready)
+		goto out;
+
+	if (!spanel->lhbm.gamma_init) {
+		strscpy(spanel->lhbm.gamma_saved, buf, sizeof(spanel->lhbm.gamma_saved));
+		goto out;
+	}
+
+	if (ctx->panel_rev < PANEL_REV_EVT1_1) {
+		ret = -EOPNOTSUPP;
+		goto out;
+	}
+
+	ret = s6e3fc3_6a_lhbm_gamma_parse(ctx, buf, gamma);
+	if (ret)
+		goto out;
+
+	s6e3fc3_6a_lhbm_gamma_restore(ctx, gamma);
+	if (ctx->enabled && ctx->current_mode &&
+	    !ctx->current_mode->exynos_mode.is_lp_mode)
+		s6e3fc3_6a_lhbm_gamma_write(ctx);
+out:
+	mutex_unlock(&ctx->mode_lock);
+
+	return ret ? ret : count;
+}
+static DEVICE_ATTR_RW(lhbm_gamma);
+
+/*
+ * Applies a gamma restored before the panel id was known, or gives userspace
+ * s6e3fc3_6a_LHBM_GAMMA_WAIT_MS to restore one before reading it back.
+ */
+static void s6e3fc3_6a_lhbm_gamma_init(struct exynos_panel *ctx)
+{
+	struct s6e3fc3_6a_lhbm *lhbm = &to_spanel(ctx)->lhbm;
+	u8 gamma[s6e3fc3_6a_LOCAL_HBM_GAMMA_CMD_SIZE - 1];
+
+	lhbm->gamma_init = true;
+	if (ctx->panel_rev < PANEL_REV_EVT1_1)
+		return;
+
+	if (lhbm->gamma_saved[0]) {
+		if (s6e3fc3_6a_lhbm_gamma_parse(ctx, lhbm->gamma_saved, gamma))
+			dev_warn(ctx->dev, "ignoring LHBM gamma saved for another panel\n");
+		else
+			s6e3fc3_6a_lhbm_gamma_restore(ctx, gamma);
+		lhbm->gamma_saved[0] = '\0';
+	}
+
+	if (!ctx->hbm.local_hbm.gamma_para_ready)
+		queue_delayed_work(system_unbound_wq, &lhbm->gamma_work,
+				   msecs_to_jiffies(s6e3fc3_6a_LHBM_GAMMA_WAIT_MS));
+	else if (ctx->enabled && ctx->current_mode &&
+		 !ctx->current_mode->exynos_mode.is_lp_mode)
+		s6e3fc3_6a_lhbm_gamma_write(ctx);
+}
+
+static struct attribute *s6e3fc3_6a_attrs[] = {
+	&dev_attr_brightness_transition.attr,
+	&dev_attr_power_state_stats.attr,
+	&dev_attr_lhbm_gamma.attr,
+	NULL
+};
 
-static const struct exynos_binned_lp s6e3fc3_6a_binned_lp[] = {
-	BINNED_LP_MODE("off", 0, s6e3fc3_6a_lp_off_cmds),
-	/* rising time = delay = 0, falling time = delay + width = 0 + 16 */
-	BINNED_LP_MODE_TIMING("low", 80, s6e3fc3_6a_lp_low_cmds, 0, 0 + 16),
-	BINNED_LP_MODE_TIMING("high", 2047, s6e3fc3_6a_lp_high_cmds, 0, 0 + 16)
+static const struct attribute_group s6e3fc3_6a_attr_group = {
+	.attrs = s6e3fc3_6a_attrs,
 };
 
-static const struct exynos_dsi_cmd s6e3fc3_6a_init_cmds[] = {
-	EXYNOS_DSI_CMD_SEQ_DELAY(120, 0x11), /* sleep out */
-	EXYNOS_DSI_CMD_SEQ(0x35), /* TE on */
-	EXYNOS_DSI_CMD_SEQ(0x2A, 0x00, 0x00, 0x04, 0x37), /* CASET */
-	EXYNOS_DSI_CMD_SEQ(0x2B, 0x00, 0x00, 0x09, 0x5F), /* PASET */
+static int s6e3fc3_6a_cooling_get_max_state(struct thermal_cooling_device *cdev,
+					    unsigned long *state)
+{
+	*state = s6e3fc3_6a_THERMAL_MAX;
 
-	EXYNOS_DSI_CMD0(test_key_on_f0),
+	return 0;
+}
 
-	/* TE rising time */
-	EXYNOS_DSI_CMD_SEQ_REV(PANEL_REV_LT(PANEL_REV_EVT1),
-			       0xB9, 0x01, 0x09, 0x5C, 0x00, 0x0B),
+static int s6e3fc3_6a_cooling_get_cur_state(struct thermal_cooling_device *cdev,
+					    unsigned long *state)
+{
+	struct exynos_panel *ctx = cdev->devdata;
 
-	/* FQ CON setting */
-	EXYNOS_DSI_CMD_SEQ(0xB0, 0x27, 0xF2 ),
-	EXYNOS_DSI_CMD_SEQ(0xF2, 0x00),
-	EXYNOS_DSI_CMD0(freq_update),
+	*state = to_spanel(ctx)->thermal.state;
 
-	/* IRC setting for HBM */
-	EXYNOS_DSI_CMD_SEQ_REV(PANEL_REV_PROTO1, 0xB0, 0x0B, 0x8F),
-	EXYNOS_DSI_CMD_SEQ_REV(PANEL_REV_PROTO1, 0x8F, 0x2B),
+	return 0;
+}
 
-	/* Enable FD in display PMIC for ELVDD and ELVSS */
-	EXYNOS_DSI_CMD_SEQ_REV(PANEL_REV_LT(PANEL_REV_EVT1), 0xB0, 0x0B, 0xF4),
-	EXYNOS_DSI_CMD_SEQ_REV(PANEL_REV_LT(PANEL_REV_EVT1), 0xF4, 0x1C),
+/*
+ * LP mode runs at its own rate with its own brightness commands, a new state
+ * takes effect there on LP exit through the normal brightness and mode paths.
+ */
+static int s6e3fc3_6a_cooling_set_cur_state(struct thermal_cooling_device *cdev,
+					    unsigned long state)
+{
+	struct exynos_panel *ctx = cdev->devdata;
+	struct s6e3fc3_6a_panel *spanel = to_spanel(ctx);
+	struct s6e3fc3_6a_thermal *thermal = &spanel->thermal;
 
-	/* Local HBM circle location setting */
-	EXYNOS_DSI_CMD0(test_key_on_f1),
-	EXYNOS_DSI_CMD_SEQ(0xB0, 0x28, 0xF2),
-	EXYNOS_DSI_CMD_SEQ(0xF2, 0xCC),
-	EXYNOS_DSI_CMD_SEQ(0xB0, 0x01, 0x34, 0x68),
-	EXYNOS_DSI_CMD_SEQ(0x68, 0x21, 0xC6, 0xB3),
-	EXYNOS_DSI_CMD_SEQ(0xB0, 0x00, 0x28, 0xF2),
-	EXYNOS_DSI_CMD_SEQ(0xF2, 0xC4),
-	EXYNOS_DSI_CMD0(test_key_off_f1),
+	if (state > s6e3fc3_6a_THERMAL_MAX)
+		return -EINVAL;
 
-	EXYNOS_DSI_CMD0(test_key_off_f0)
+	mutex_lock(&ctx->mode_lock);
+	if (thermal->state == state)
+		goto out;
+
+	dev_info(ctx->dev, "thermal state %lu -> %lu\n", thermal->state, state);
+	thermal->state = state;
+
+	if (!ctx->enabled || !ctx->current_mode ||
+	    ctx->current_mode->exynos_mode.is_lp_mode)
+		goto out;
+
+	s6e3fc3_6a_request_hbm_mode(ctx, thermal->hbm_req, false);
+	if (ctx->bl)
+		s6e3fc3_6a_set_brightness(ctx, ctx->bl->props.brightness);
+	s6e3fc3_6a_change_frequency(ctx, spanel->idle.active ?
+				    s6e3fc3_6a_IDLE_VREFRESH : spanel->idle.vrefresh);
+out:
+	mutex_unlock(&ctx->mode_lock);
+
+	return 0;
+}
+
+static const struct thermal_cooling_device_ops s6e3fc3_6a_cooling_ops = {
+	.get_max_state = s6e3fc3_6a_cooling_get_max_state,
+	.get_cur_state = s6e3fc3_6a_cooling_get_cur_state,
+	.set_cur_state = s6e3fc3_6a_cooling_set_cur_state,
 };
-static DEFINE_EXYNOS_CMD_SET(s6e3fc3_6a_init);
 
-static void s6e3fc3_6a_get_te2_setting(struct exynos_panel_te2_timing *timing,
-				    u8 *setting)
+static void s6e3fc3_6a_mode_set(struct exynos_panel *ctx,
+			     const struct exynos_panel_mode *pmode)
 {
-	u8 delay_low_byte, delay_high_byte;
-	u8 width_low_byte, width_high_byte;
-	u32 rising, falling;
+	struct s6e3fc3_6a_idle *idle = &to_spanel(ctx)->idle;
 
-	if (!timing || !setting)
+	if (!ctx->enabled)
 		return;
 
-	rising = timing->rising_edge;
-	falling = timing->falling_edge;
+	idle->vrefresh = drm_mode_vrefresh(&pmode->mode);
+	idle->active = false;
+	to_spanel(ctx)->state.vrefresh = idle->vrefresh;
+	s6e3fc3_6a_state_commit(ctx, s6e3fc3_6a_STATE_FREQ);
+}
+
+static bool s6e3fc3_6a_is_mode_seamless(const struct exynos_panel *ctx,
+				     const struct exynos_panel_mode *pmode)
+{
+	const struct exynos_panel_mode *cur = ctx->current_mode;
 
-	delay_low_byte = rising & 0xFF;
-	delay_high_byte = (rising >> 8) & 0xF;
-	width_low_byte = (falling - rising) & 0xFF;
-	width_high_byte = ((falling - rising) >> 8) & 0xF;
+	/* a different slice layout needs a new PPS, which is only sent on enable */
+	if (cur->exynos_mode.dsc.slice_count != pmode->exynos_mode.dsc.slice_count ||
+	    cur->exynos_mode.dsc.slice_height != pmode->exynos_mode.dsc.slice_height)
+		return false;
 
-	setting[0] = (delay_high_byte << 4) | width_high_byte;
-	setting[1] = delay_low_byte;
-	setting[2] = width_low_byte;
+	/* seamless mode switch is possible if only changing refresh rate */
+	return drm_mode_equal_no_clocks(&cur->mode, &pmode->mode);
 }
 
-static void s6e3fc3_6a_update_te2(struct exynos_panel *ctx)
+static int s6e3fc3_6a_enable_stages_show(struct seq_file *m, void *data)
 {
-	struct exynos_panel_te2_timing timing;
-	u8 setting[2][4] = {
-		{0xCB, 0x00, 0x00, 0x30}, // normal 60Hz
-		{0xCB, 0x00, 0x00, 0x30}, // normal 90Hz
-	};
-	u8 lp_setting[4] = {0xCB, 0x00, 0x00, 0x10}; // lp low/high
-	int ret, i;
+	struct exynos_panel *ctx = m->private;
+	struct s6e3fc3_6a_panel *spanel = to_spanel(ctx);
+	int i;
 
-	if (!ctx)
-		return;
+	for (i = 0; i < s6e3fc3_6a_STAGE_MAX; i++)
+		seq_printf(m, "%s: %u\n", s6e3fc3_6a_enable_stage_names[i],
+			   spanel->enable_stage_us[i]);
 
-	if (ctx->panel_rev == PANEL_REV_PROTO1) {
-		dev_dbg(ctx->dev, "No need to send TE2 commands on P1.0\n");
-		return;
-	}
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(s6e3fc3_6a_enable_stages);
 
-	/* normal mode */
-	for (i = 0; i < 2; i++) {
-		timing.rising_edge = ctx->te2.mode_data[i].timing.rising_edge;
-		timing.falling_edge = ctx->te2.mode_data[i].timing.falling_edge;
+static int s6e3fc3_6a_lhbm_latency_show(struct seq_file *m, void *data)
+{
+	struct exynos_panel *ctx = m->private;
+	struct s6e3fc3_6a_lhbm *lhbm = &to_spanel(ctx)->lhbm;
 
-		s6e3fc3_6a_get_te2_setting(&timing, &setting[i][1]);
+	s6e3fc3_6a_hist_show(m, "request_to_te_us", &lhbm->to_te);
+	s6e3fc3_6a_hist_show(m, "request_to_frame_us", &lhbm->to_frame);
+	seq_printf(m, "gamma: source=%s read_us=%u\n",
+		   lhbm->gamma_source ?: "none", lhbm->gamma_read_us);
 
-		dev_dbg(ctx->dev, "TE2 updated normal %dHz: 0xcb 0x%x 0x%x 0x%x\n",
-			(i == 0) ? 60 : 90,
-			setting[i][1], setting[i][2], setting[i][3]);
-	}
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(s6e3fc3_6a_lhbm_latency);
 
-	/* LP mode */
-	if (ctx->current_mode->exynos_mode.is_lp_mode) {
-		ret = exynos_panel_get_current_mode_te2(ctx, &timing);
-		if (!ret)
-			s6e3fc3_6a_get_te2_setting(&timing, &lp_setting[1]);
-		else if (ret == -EAGAIN)
-			dev_dbg(ctx->dev,
-				"Panel is not ready, use default setting\n");
-		else
-			return;
+static int s6e3fc3_6a_op_latency_show(struct seq_file *m, void *data)
+{
+	struct exynos_panel *ctx = m->private;
+	struct s6e3fc3_6a_panel *spanel = to_spanel(ctx);
+	int i;
 
-		dev_dbg(ctx->dev, "TE2 updated LP: 0xcb 0x%x 0x%x 0x%x\n",
-			lp_setting[1], lp_setting[2], lp_setting[3]);
-	}
+	for (i = 0; i < s6e3fc3_6a_OP_MAX; i++)
+		s6e3fc3_6a_hist_show(m, s6e3fc3_6a_op_names[i], &spanel->op_hist[i]);
 
-	EXYNOS_DCS_WRITE_TABLE(ctx, test_key_on_f0);
-	EXYNOS_DCS_WRITE_SEQ(ctx, 0xB0, 0x28, 0xF2); /* global para  */
-	EXYNOS_DCS_WRITE_SEQ(ctx, 0xF2, 0xCC); /* global para 10bit */
-	EXYNOS_DCS_WRITE_SEQ(ctx, 0xB0, 0x00, 0x26, 0xF2); /* global para */
-	EXYNOS_DCS_WRITE_SEQ(ctx, 0xF2, 0x03, 0x14); /* TE2 on */
-	EXYNOS_DCS_WRITE_SEQ(ctx, 0xB0, 0x00, 0xAF, 0xCB); /* global para */
-	EXYNOS_DCS_WRITE_TABLE(ctx, setting[0]); /* 60Hz control */
-	EXYNOS_DCS_WRITE_SEQ(ctx, 0xB0, 0x01, 0x2F, 0xCB); /* global para */
-	EXYNOS_DCS_WRITE_TABLE(ctx, setting[1]); /* 90Hz control */
-	if (ctx->current_mode->exynos_mode.is_lp_mode) {
-		EXYNOS_DCS_WRITE_SEQ(ctx, 0xB0, 0x01, 0xAF, 0xCB); /* global para */
-		EXYNOS_DCS_WRITE_TABLE(ctx, lp_setting); /* HLPM mode */
-	}
-	EXYNOS_DCS_WRITE_SEQ(ctx, 0xB0, 0x00, 0x28, 0xF2); /* global para */
-	EXYNOS_DCS_WRITE_SEQ(ctx, 0xF2, 0xC4); /* global para 8bit */
-	EXYNOS_DCS_WRITE_TABLE(ctx, freq_update); /* LTPS update */
-	EXYNOS_DCS_WRITE_TABLE(ctx, test_key_off_f0);
+	return 0;
 }
+DEFINE_SHOW_ATTRIBUTE(s6e3fc3_6a_op_latency);
 
-static void s6e3fc3_6a_change_frequency(struct exynos_panel *ctx,
-				     unsigned int vrefresh)
+static int s6e3fc3_6a_idle_show(struct seq_file *m, void *data)
 {
-	if (!ctx || (vrefresh != 60 && vrefresh != 90))
-		return;
+	struct exynos_panel *ctx = m->private;
+	struct s6e3fc3_6a_panel *spanel = to_spanel(ctx);
+	struct s6e3fc3_6a_freq_stats *stats = &spanel->freq_stats;
+	u64 ms = ktime_ms_delta(ktime_get(), stats->since);
 
-	EXYNOS_DCS_WRITE_TABLE(ctx, test_key_on_f0);
-	EXYNOS_DCS_WRITE_SEQ(ctx, 0x60, (vrefresh == 90) ? 0x10 : 0x00);
-	EXYNOS_DCS_WRITE_TABLE(ctx, freq_update);
-	EXYNOS_DCS_WRITE_TABLE(ctx, test_key_off_f0);
+	seq_printf(m, "active: %d\n", spanel->idle.active);
+	seq_printf(m, "downshifts: %u\n", spanel->idle.count);
+	seq_printf(m, "60hz_ms: %llu\n", stats->ms_60hz + (stats->vrefresh == 60 ? ms : 0));
+	seq_printf(m, "90hz_ms: %llu\n", stats->ms_90hz + (stats->vrefresh == 90 ? ms : 0));
+	s6e3fc3_6a_hist_show(m, "wakeup_us", &spanel->idle.wakeup);
 
-	dev_dbg(ctx->dev, "%s: change to %uhz\n", __func__, vrefresh);
+	return 0;
 }
+DEFINE_SHOW_ATTRIBUTE(s6e3fc3_6a_idle);
 
-static void s6e3fc3_6a_update_wrctrld(struct exynos_panel *ctx)
+static void s6e3fc3_6a_te_hist_show(struct seq_file *m, const char *name,
+				    const struct s6e3fc3_6a_te_hist *hist)
 {
-	u8 val = s6e3fc3_6a_WRCTRLD_BCTRL_BIT;
+	seq_printf(m, "  %s: count=%u p1=%u p5=%u p50=%u p95=%u p99=%u max=%u\n",
+		   name, hist->count,
+		   s6e3fc3_6a_te_hist_percentile(hist, 1),
+		   s6e3fc3_6a_te_hist_percentile(hist, 5),
+		   s6e3fc3_6a_te_hist_percentile(hist, 50),
+		   s6e3fc3_6a_te_hist_percentile(hist, 95),
+		   s6e3fc3_6a_te_hist_percentile(hist, 99),
+		   hist->max_us);
+}
 
-	if (IS_HBM_ON(ctx->hbm_mode))
-		val |= s6e3fc3_6a_WRCTRLD_HBM_BIT;
+static int s6e3fc3_6a_te_stats_show(struct seq_file *m, void *data)
+{
+	struct exynos_panel *ctx = m->private;
+	struct s6e3fc3_6a_te_stats *stats = &to_spanel(ctx)->te_stats;
+	int i;
+
+	for (i = 0; i < s6e3fc3_6a_TE_MODES_MAX; i++) {
+		const struct s6e3fc3_6a_te_mode_stats *mstats = &stats->mode[i];
+		const struct exynos_panel_mode *pmode = mstats->pmode;
+
+		if (!pmode)
+			break;
+
+		seq_printf(m, "%ux%u@%d%s: frames=%u missed=%u late=%u te_idle_us=%u\n",
+			   pmode->mode.hdisplay, pmode->mode.vdisplay,
+			   drm_mode_vrefresh(&pmode->mode),
+			   pmode->exynos_mode.is_lp_mode ? " lp" : "",
+			   mstats->frames, mstats->missed, mstats->late,
+			   pmode->exynos_mode.underrun_param ?
+			   pmode->exynos_mode.underrun_param->te_idle_us : 0);
+		s6e3fc3_6a_te_hist_show(m, "jitter_us", &mstats->jitter);
+		s6e3fc3_6a_te_hist_show(m, "slack_us", &mstats->slack);
+	}
 
-	if (ctx->hbm.local_hbm.enabled)
-		val |= s6e3fc3_6a_WRCTRLD_LOCAL_HBM_BIT;
+	return 0;
+}
 
-	if (ctx->dimming_on)
-		val |= s6e3fc3_6a_WRCTRLD_DIMMING_BIT;
+static int s6e3fc3_6a_te_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, s6e3fc3_6a_te_stats_show, inode->i_private);
+}
 
-	dev_dbg(ctx->dev,
-		"%s(wrctrld:0x%x, hbm: %s, dimming: %s, local_hbm: %s)\n",
-		__func__, val, IS_HBM_ON(ctx->hbm_mode) ? "on" : "off",
-		ctx->dimming_on ? "on" : "off",
-		ctx->hbm.local_hbm.enabled ? "on" : "off");
+/* any write clears the stats */
+static ssize_t s6e3fc3_6a_te_stats_write(struct file *file, const char __user *buf,
+					 size_t count, loff_t *ppos)
+{
+	struct seq_file *m = file->private_data;
+	struct exynos_panel *ctx = m->private;
+	struct s6e3fc3_6a_te_stats *stats = &to_spanel(ctx)->te_stats;
 
-	EXYNOS_DCS_WRITE_SEQ(ctx, MIPI_DCS_WRITE_CONTROL_DISPLAY, val);
+	mutex_lock(&ctx->mode_lock);
+	memset(stats, 0, sizeof(*stats));
+	mutex_unlock(&ctx->mode_lock);
 
-	/* TODO: need to perform gamma updates */
+	return count;
 }
 
-static void s6e3fc3_6a_set_nolp_mode(struct exynos_panel *ctx,
-				  const struct exynos_panel_mode *pmode)
+static const struct file_operations s6e3fc3_6a_te_stats_fops = {
+	.owner = THIS_MODULE,
+	.open = s6e3fc3_6a_te_stats_open,
+	.read = seq_read,
+	.write = s6e3fc3_6a_te_stats_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int s6e3fc3_6a_aod_show(struct seq_file *m, void *data)
 {
-	unsigned int vrefresh = drm_mode_vrefresh(&pmode->mode);
-	u32 delay_us = mult_frac(1000, 1020, vrefresh);
+	struct exynos_panel *ctx = m->private;
+	struct s6e3fc3_6a_aod *aod = &to_spanel(ctx)->aod;
+	u64 lp_ms = aod->lp_ms;
 
-	if (!ctx->enabled)
-		return;
+	if (aod->lp_start)
+		lp_ms += ktime_ms_delta(ktime_get(), aod->lp_start);
 
-	EXYNOS_DCS_WRITE_TABLE(ctx, display_off);
-	s6e3fc3_6a_update_wrctrld(ctx);
-	s6e3fc3_6a_change_frequency(ctx, vrefresh);
-	usleep_range(delay_us, delay_us + 10);
-	EXYNOS_DCS_WRITE_TABLE(ctx, display_on);
+	seq_printf(m, "bin: %s\n", aod->bin >= 0 ?
+		   ctx->desc->binned_lp[aod->bin].name : "unknown");
+	seq_printf(m, "lp_ms: %llu\n", lp_ms);
+	seq_printf(m, "transitions: %u\n", aod->transitions);
+	seq_printf(m, "suppressed: %u\n", aod->suppressed);
+	seq_printf(m, "transitions_per_hour: %llu\n",
+		   lp_ms ? div64_u64((u64)aod->transitions * MSEC_PER_SEC * 3600, lp_ms) : 0);
 
-	dev_info(ctx->dev, "exit LP mode\n");
+	return 0;
 }
+DEFINE_SHOW_ATTRIBUTE(s6e3fc3_6a_aod);
 
-#define s6e3fc3_6a_LOCAL_HBM_GAMMA_CMD_SIZE 6
-static int s6e3fc3_6a_lhbm_gamma_read(struct exynos_panel *ctx)
+static int s6e3fc3_6a_pps_show(struct seq_file *m, void *data)
 {
-	struct mipi_dsi_device *dsi = to_mipi_dsi_device(ctx->dev);
-	u8 *gamma_cmd = ctx->hbm.local_hbm.gamma_cmd;
-	int ret;
-
-	EXYNOS_DCS_WRITE_TABLE(ctx, test_key_on_f0);
-	EXYNOS_DCS_WRITE_SEQ(ctx, 0xB0, 0x28, 0xF2); /* global para*/
-	EXYNOS_DCS_WRITE_SEQ(ctx, 0xF2, 0xCC); /* 10 bit */
-	EXYNOS_DCS_WRITE_SEQ(ctx, 0xB0, 0x00, 0x22, 0xD8); /* global para */
-	ret = mipi_dsi_dcs_read(dsi, 0xD8, gamma_cmd + 1, s6e3fc3_6a_LOCAL_HBM_GAMMA_CMD_SIZE - 1);
-	if (ret == (s6e3fc3_6a_LOCAL_HBM_GAMMA_CMD_SIZE - 1)) {
-		gamma_cmd[0] = 0x65;
-		ctx->hbm.local_hbm.gamma_para_ready = true;
-		ret = 0;
-	} else {
-		dev_err(ctx->dev, "fail to read LHBM gamma\n");
-		ret = -EIO;
+	struct exynos_panel *ctx = m->private;
+	struct s6e3fc3_6a_panel *spanel = to_spanel(ctx);
+	int i;
+
+	for (i = 0; i < spanel->num_pps; i++) {
+		const struct s6e3fc3_6a_pps *pps = &spanel->pps[i];
+		const struct drm_display_mode *mode = &pps->pmode->mode;
+		const u32 slice_count = pps->pmode->exynos_mode.dsc.slice_count;
+
+		seq_printf(m, "%ux%u@%d%s: slices %ux%u chunk %u frame %u bytes\n",
+			   mode->hdisplay, mode->vdisplay, drm_mode_vrefresh(mode),
+			   pps->pmode->exynos_mode.is_lp_mode ? " lp" : "",
+			   slice_count, pps->pmode->exynos_mode.dsc.slice_height,
+			   pps->chunk_size,
+			   pps->chunk_size * slice_count * mode->vdisplay);
+		seq_hex_dump(m, "  ", DUMP_PREFIX_OFFSET, 16, 1, &pps->pps,
+			     sizeof(pps->pps), false);
 	}
-	EXYNOS_DCS_WRITE_SEQ(ctx, 0xB0, 0x00, 0x28, 0xF2); /* global para*/
-	EXYNOS_DCS_WRITE_SEQ(ctx, 0xF2, 0xC4); /* 8 bit */
-	EXYNOS_DCS_WRITE_TABLE(ctx, test_key_off_f0);
-	return ret;
+
+	return 0;
 }
+DEFINE_SHOW_ATTRIBUTE(s6e3fc3_6a_pps);
 
-static void s6e3fc3_6a_lhbm_gamma_write(struct exynos_panel *ctx)
+/* DSI short packets carry up to two bytes, long packets add a header and CRC */
+#define s6e3fc3_6a_DSI_SHORT_PKT_BYTES	4
+#define s6e3fc3_6a_DSI_LONG_PKT_OVERHEAD	6
+
+/* cost of the commands of @cmd_set that apply to the panel revision */
+static void s6e3fc3_6a_cmd_set_cost_show(struct seq_file *m, const char *name,
+					 const struct exynos_dsi_cmd_set *cmd_set)
 {
-	EXYNOS_DCS_WRITE_TABLE(ctx, test_key_on_f0);
-	EXYNOS_DCS_WRITE_SEQ(ctx, 0xB0, 0x28, 0xF2); /* global para*/
-	EXYNOS_DCS_WRITE_SEQ(ctx, 0xF2, 0xCC); /* 10 bit */
-	EXYNOS_DCS_WRITE_SEQ(ctx, 0xB0, 0x03, 0xCD, 0x65); /* global para */
-	exynos_dcs_write(ctx, ctx->hbm.local_hbm.gamma_cmd,
-			 s6e3fc3_6a_LOCAL_HBM_GAMMA_CMD_SIZE); /* write gamma */
-	EXYNOS_DCS_WRITE_SEQ(ctx, 0xB0, 0x00, 0x28, 0xF2); /* global para*/
-	EXYNOS_DCS_WRITE_SEQ(ctx, 0xF2, 0xC4); /* 8 bit */
-	EXYNOS_DCS_WRITE_TABLE(ctx, test_key_off_f0);
+	struct exynos_panel *ctx = m->private;
+	u32 i, transfers = 0, bytes = 0, wire_bytes = 0, delay_ms = 0;
+
+	if (!cmd_set)
+		return;
+
+	for (i = 0; i < cmd_set->num_cmd; i++) {
+		const struct exynos_dsi_cmd *cmd = &cmd_set->cmds[i];
+
+		if (cmd->panel_rev && !(cmd->panel_rev & ctx->panel_rev))
+			continue;
+
+		transfers++;
+		bytes += cmd->cmd_len;
+		wire_bytes += cmd->cmd_len <= 2 ? s6e3fc3_6a_DSI_SHORT_PKT_BYTES :
+			      cmd->cmd_len + s6e3fc3_6a_DSI_LONG_PKT_OVERHEAD;
+		delay_ms += cmd->delay_ms;
+	}
+
+	seq_printf(m, "%s: transfers=%u bytes=%u wire_bytes=%u delay_ms=%u\n",
+		   name, transfers, bytes, wire_bytes, delay_ms);
 }
 
-static int s6e3fc3_6a_enable(struct drm_panel *panel)
+/*
+ * DSI cost of the command sets and the timing of each mode, as input for
+ * models of the panel such as a virtual panel.
+ */
+static int s6e3fc3_6a_cmdset_cost_show(struct seq_file *m, void *data)
 {
-	struct exynos_panel *ctx = container_of(panel, struct exynos_panel, panel);
-	const struct exynos_panel_mode *pmode = ctx->current_mode;
-	const struct drm_display_mode *mode;
-
-	if (!pmode) {
-		dev_err(ctx->dev, "no current mode set\n");
-		return -EINVAL;
+	struct exynos_panel *ctx = m->private;
+	const struct exynos_panel_desc *desc = ctx->desc;
+	int i;
+
+	s6e3fc3_6a_cmd_set_cost_show(m, "init", &s6e3fc3_6a_init_cmd_set);
+	s6e3fc3_6a_cmd_set_cost_show(m, "pwm_1", &s6e3fc3_6a_1_pwm_cmd_set);
+	s6e3fc3_6a_cmd_set_cost_show(m, "pwm_4", &s6e3fc3_6a_4_pwm_cmd_set);
+	s6e3fc3_6a_cmd_set_cost_show(m, "off", desc->off_cmd_set);
+	s6e3fc3_6a_cmd_set_cost_show(m, "lp", desc->lp_cmd_set);
+	for (i = 0; i < desc->num_binned_lp; i++)
+		s6e3fc3_6a_cmd_set_cost_show(m, desc->binned_lp[i].name,
+					     &desc->binned_lp[i].cmd_set);
+
+	for (i = 0; i <= desc->num_modes; i++) {
+		const struct exynos_panel_mode *pmode =
+			i < desc->num_modes ? &desc->modes[i] : desc->lp_mode;
+
+		if (!pmode)
+			break;
+		seq_printf(m, "mode %ux%u@%d%s: clock=%d vtotal=%u vblank_us=%u\n",
+			   pmode->mode.hdisplay, pmode->mode.vdisplay,
+			   drm_mode_vrefresh(&pmode->mode),
+			   pmode->exynos_mode.is_lp_mode ? " lp" : "",
+			   pmode->mode.clock, pmode->mode.vtotal,
+			   pmode->exynos_mode.vblank_usec);
 	}
-	mode = &pmode->mode;
 
-	dev_dbg(ctx->dev, "%s\n", __func__);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(s6e3fc3_6a_cmdset_cost);
 
-	exynos_panel_reset(ctx);
+/* one "key value" pair per line so replay tools can diff snapshots */
+static int s6e3fc3_6a_io_stats_show(struct seq_file *m, void *data)
+{
+	struct exynos_panel *ctx = m->private;
+	struct s6e3fc3_6a_panel *spanel = to_spanel(ctx);
+	const struct s6e3fc3_6a_io_stats *stats = &spanel->io_stats;
+	int i;
+
+	seq_printf(m, "tx_count %u\n", stats->tx_count);
+	seq_printf(m, "tx_bytes %llu\n", stats->tx_bytes);
+	seq_printf(m, "rx_count %u\n", stats->rx_count);
+	seq_printf(m, "rx_bytes %llu\n", stats->rx_bytes);
+	seq_printf(m, "tx_errors %u\n", stats->tx_errors);
+	seq_printf(m, "rx_errors %u\n", stats->rx_errors);
+	seq_printf(m, "sleeps %u\n", stats->sleeps);
+	seq_printf(m, "sleep_us %llu\n", stats->sleep_us);
+	for (i = 0; i < s6e3fc3_6a_OP_MAX; i++) {
+		const struct s6e3fc3_6a_hist *hist = &spanel->op_hist[i];
+
+		seq_printf(m, "%s_count %u\n", s6e3fc3_6a_op_names[i], hist->count);
+		seq_printf(m, "%s_sum_us %llu\n", s6e3fc3_6a_op_names[i], hist->sum_us);
+		seq_printf(m, "%s_max_us %u\n", s6e3fc3_6a_op_names[i], hist->max_us);
+	}
+	seq_printf(m, "state_flushes %u\n", spanel->state.transfers.count);
+	seq_printf(m, "state_flush_transfers %llu\n", spanel->state.transfers.sum_us);
+	seq_printf(m, "state_flush_max_transfers %u\n", spanel->state.transfers.max_us);
+	seq_printf(m, "state_spilled %u\n", spanel->state.spilled);
+	seq_printf(m, "notify_events %u\n", spanel->notify.events);
+	seq_printf(m, "notify_sum_us %llu\n", spanel->notify.hist.sum_us);
+	seq_printf(m, "notify_max_us %u\n", spanel->notify.hist.max_us);
 
-	exynos_panel_send_cmd_set(ctx, &s6e3fc3_6a_init_cmd_set);
+	return 0;
+}
 
-	s6e3fc3_6a_change_frequency(ctx, drm_mode_vrefresh(mode));
+static int s6e3fc3_6a_io_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, s6e3fc3_6a_io_stats_show, inode->i_private);
+}
 
-	if (ctx->panel_rev == PANEL_REV_PROTO1_1)
-		exynos_panel_send_cmd_set(ctx, &s6e3fc3_6a_4_pwm_cmd_set);
-	else if (ctx->panel_rev >= PANEL_REV_EVT1_1)
-		if (ctx->hbm.local_hbm.gamma_para_ready)
-			s6e3fc3_6a_lhbm_gamma_write(ctx);
+/* any write clears the DSI, sleep and operation counters */
+static ssize_t s6e3fc3_6a_io_stats_write(struct file *file, const char __user *buf,
+					 size_t count, loff_t *ppos)
+{
+	struct seq_file *m = file->private_data;
+	struct exynos_panel *ctx = m->private;
+	struct s6e3fc3_6a_panel *spanel = to_spanel(ctx);
 
-	/* DSC related configuration */
-	exynos_dcs_compression_mode(ctx, 0x1); /* DSC_DEC_ON */
-	EXYNOS_PPS_LONG_WRITE(ctx); /* PPS_SETTING */
-	EXYNOS_DCS_WRITE_SEQ(ctx, 0xC2, 0x14); /* PPS_MIC_OFF */
-	EXYNOS_DCS_WRITE_SEQ(ctx, 0x9D, 0x01); /* PPS_DSC_EN */
+	mutex_lock(&ctx->mode_lock);
+	memset(&spanel->io_stats, 0, sizeof(spanel->io_stats));
+	memset(spanel->op_hist, 0, sizeof(spanel->op_hist));
+	spanel->esd.tx_errors = 0;
+	mutex_unlock(&ctx->mode_lock);
 
-	s6e3fc3_6a_update_wrctrld(ctx); /* dimming and HBM */
+	return count;
+}
 
-	ctx->enabled = true;
+static const struct file_operations s6e3fc3_6a_io_stats_fops = {
+	.owner = THIS_MODULE,
+	.open = s6e3fc3_6a_io_stats_open,
+	.read = seq_read,
+	.write = s6e3fc3_6a_io_stats_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
 
-	if (pmode->exynos_mode.is_lp_mode)
-		exynos_panel_set_lp_mode(ctx, pmode);
-	else
-		EXYNOS_DCS_WRITE_SEQ(ctx, 0x29); /* display on */
+static int s6e3fc3_6a_esd_show(struct seq_file *m, void *data)
+{
+	struct exynos_panel *ctx = m->private;
+	const struct s6e3fc3_6a_esd *esd = &to_spanel(ctx)->esd;
+	int i;
+
+	seq_printf(m, "period_ms %u\n", esd->period_ms);
+	for (i = s6e3fc3_6a_ESD_NONE + 1; i < s6e3fc3_6a_ESD_FAULT_MAX; i++)
+		seq_printf(m, "%s %u\n", s6e3fc3_6a_esd_fault_names[i], esd->faults[i]);
+	seq_printf(m, "restored %u\n", esd->restored);
+	seq_printf(m, "resets %u\n", esd->resets);
+	seq_printf(m, "failed %u\n", esd->failed);
+	seq_printf(m, "retries %u\n", esd->retries);
 
 	return 0;
 }
 
-static void s6e3fc3_6a_set_hbm_mode(struct exynos_panel *exynos_panel,
-				enum exynos_hbm_mode mode)
+static int s6e3fc3_6a_esd_open(struct inode *inode, struct file *file)
 {
-	const bool hbm_update =
-		(IS_HBM_ON(exynos_panel->hbm_mode) != IS_HBM_ON(mode));
-	const bool irc_update =
-		(IS_HBM_ON_IRC_OFF(exynos_panel->hbm_mode) != IS_HBM_ON_IRC_OFF(mode));
+	return single_open(file, s6e3fc3_6a_esd_show, inode->i_private);
+}
 
-	exynos_panel->hbm_mode = mode;
+/*
+ * Writing a fault name makes the next check report it and runs the check
+ * right away, "clear" clears the counters.
+ */
+static ssize_t s6e3fc3_6a_esd_write(struct file *file, const char __user *ubuf,
+				    size_t count, loff_t *ppos)
+{
+	struct seq_file *m = file->private_data;
+	struct exynos_panel *ctx = m->private;
+	struct s6e3fc3_6a_esd *esd = &to_spanel(ctx)->esd;
+	char buf[16];
+	int fault;
 
-	if (hbm_update) {
-		if (exynos_panel->panel_rev == PANEL_REV_PROTO1_1) {
-			if (IS_HBM_ON(mode))
-				exynos_panel_send_cmd_set(exynos_panel, &s6e3fc3_6a_1_pwm_cmd_set);
-			else
-				exynos_panel_send_cmd_set(exynos_panel, &s6e3fc3_6a_4_pwm_cmd_set);
-		}
-		s6e3fc3_6a_update_wrctrld(exynos_panel);
-	}
-	if (irc_update) {
-		EXYNOS_DCS_WRITE_SEQ(exynos_panel, 0xF0, 0x5A, 0x5A);
-		EXYNOS_DCS_WRITE_SEQ(exynos_panel, 0xB0, 0x03, 0x8F);
-		EXYNOS_DCS_WRITE_SEQ(exynos_panel, 0x8F, IS_HBM_ON_IRC_OFF(mode) ? 0x05 : 0x25);
-		EXYNOS_DCS_WRITE_SEQ(exynos_panel, 0xF0, 0xA5, 0xA5);
+	if (count >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, ubuf, count))
+		return -EFAULT;
+	buf[count] = '\0';
+
+	if (sysfs_streq(buf, "clear")) {
+		mutex_lock(&ctx->mode_lock);
+		memset(esd->faults, 0, sizeof(esd->faults));
+		esd->restored = 0;
+		esd->resets = 0;
+		esd->failed = 0;
+		mutex_unlock(&ctx->mode_lock);
+		return count;
 	}
-	dev_info(exynos_panel->dev, "hbm_on=%d hbm_ircoff=%d\n", IS_HBM_ON(exynos_panel->hbm_mode),
-		 IS_HBM_ON_IRC_OFF(exynos_panel->hbm_mode));
-}
 
-static void s6e3fc3_6a_set_dimming_on(struct exynos_panel *exynos_panel,
-				 bool dimming_on)
-{
-	exynos_panel->dimming_on = dimming_on;
+	fault = sysfs_match_string(s6e3fc3_6a_esd_fault_names, buf);
+	if (fault <= s6e3fc3_6a_ESD_NONE)
+		return -EINVAL;
+
+	mutex_lock(&ctx->mode_lock);
+	esd->inject = fault;
+	mutex_unlock(&ctx->mode_lock);
+	mod_delayed_work(system_wq, &esd->work, 0);
 
-	s6e3fc3_6a_update_wrctrld(exynos_panel);
+	return count;
 }
 
-static void s6e3fc3_6a_set_local_hbm_mode(struct exynos_panel *exynos_panel,
-				 bool local_hbm_en)
+static const struct file_operations s6e3fc3_6a_esd_fops = {
+	.owner = THIS_MODULE,
+	.open = s6e3fc3_6a_esd_open,
+	.read = seq_read,
+	.write = s6e3fc3_6a_esd_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int s6e3fc3_6a_esd_period_get(void *data, u64 *val)
 {
-	if (exynos_panel->hbm.local_hbm.enabled == local_hbm_en)
-		return;
+	struct exynos_panel *ctx = data;
 
-	exynos_panel->hbm.local_hbm.enabled = local_hbm_en;
-	s6e3fc3_6a_update_wrctrld(exynos_panel);
+	*val = to_spanel(ctx)->esd.period_ms;
+
+	return 0;
 }
 
-static void s6e3fc3_6a_mode_set(struct exynos_panel *ctx,
-			     const struct exynos_panel_mode *pmode)
+/* the watchdog costs a DCS read per period, it only runs once given one */
+static int s6e3fc3_6a_esd_period_set(void *data, u64 val)
 {
-	if (!ctx->enabled)
-		return;
+	struct exynos_panel *ctx = data;
+	struct s6e3fc3_6a_esd *esd = &to_spanel(ctx)->esd;
+
+	if (val > U32_MAX)
+		return -EINVAL;
+
+	mutex_lock(&ctx->mode_lock);
+	esd->period_ms = val;
+	if (!esd->period_ms) {
+		/* the work rechecks the period under mode_lock, no need to sync */
+		cancel_delayed_work(&esd->work);
+	} else if (ctx->enabled && !esd->busy) {
+		esd->retries = 0;
+		esd->tx_errors = to_spanel(ctx)->io_stats.tx_errors;
+		mod_delayed_work(system_wq, &esd->work, msecs_to_jiffies(esd->period_ms));
+	}
+	mutex_unlock(&ctx->mode_lock);
 
-	s6e3fc3_6a_change_frequency(ctx, drm_mode_vrefresh(&pmode->mode));
+	return 0;
 }
+DEFINE_DEBUGFS_ATTRIBUTE(s6e3fc3_6a_esd_period_fops, s6e3fc3_6a_esd_period_get,
+			 s6e3fc3_6a_esd_period_set, "%llu\n");
 
-static bool s6e3fc3_6a_is_mode_seamless(const struct exynos_panel *ctx,
-				     const struct exynos_panel_mode *pmode)
+static void s6e3fc3_6a_debugfs_init(struct exynos_panel *ctx, struct dentry *csroot)
 {
-	/* seamless mode switch is possible if only changing refresh rate */
-	return drm_mode_equal_no_clocks(&ctx->current_mode->mode, &pmode->mode);
+	struct s6e3fc3_6a_panel *spanel = to_spanel(ctx);
+	struct s6e3fc3_6a_shadow *shadow = &spanel->shadow;
+	struct dentry *shadow_root;
+
+	if (!csroot)
+		return;
+
+	debugfs_create_file("cost", 0400, csroot, ctx, &s6e3fc3_6a_cmdset_cost_fops);
+
+	shadow_root = debugfs_create_dir("shadow", csroot->d_parent);
+	debugfs_create_u32("hit", 0600, shadow_root, &shadow->hit);
+	debugfs_create_u32("miss", 0600, shadow_root, &shadow->miss);
+
+	debugfs_create_bool("lp_exit_blocking", 0600, csroot->d_parent,
+			    &spanel->lp_exit_blocking);
+	debugfs_create_u32("lp_exit_last_us", 0400, csroot->d_parent,
+			   &spanel->lp_exit_last_us);
+	debugfs_create_u32("lp_exit_max_us", 0600, csroot->d_parent,
+			   &spanel->lp_exit_max_us);
+	debugfs_create_file("enable_stages_us", 0400, csroot->d_parent, ctx,
+			    &s6e3fc3_6a_enable_stages_fops);
+	debugfs_create_file("lhbm_latency", 0400, csroot->d_parent, ctx,
+			    &s6e3fc3_6a_lhbm_latency_fops);
+	debugfs_create_file("op_latency_us", 0400, csroot->d_parent, ctx,
+			    &s6e3fc3_6a_op_latency_fops);
+	debugfs_create_u32("idle_frames", 0600, csroot->d_parent,
+			   &spanel->idle.frames);
+	debugfs_create_file("idle", 0400, csroot->d_parent, ctx,
+			    &s6e3fc3_6a_idle_fops);
+	debugfs_create_u32("aod_hysteresis", 0600, csroot->d_parent,
+			   &spanel->aod.hysteresis);
+	debugfs_create_u32("aod_min_dwell_ms", 0600, csroot->d_parent,
+			   &spanel->aod.min_dwell_ms);
+	debugfs_create_file("aod", 0400, csroot->d_parent, ctx,
+			    &s6e3fc3_6a_aod_fops);
+	debugfs_create_file("pps", 0400, csroot->d_parent, ctx,
+			    &s6e3fc3_6a_pps_fops);
+	debugfs_create_file("te_stats", 0600, csroot->d_parent, ctx,
+			    &s6e3fc3_6a_te_stats_fops);
+	debugfs_create_file("io_stats", 0600, csroot->d_parent, ctx,
+			    &s6e3fc3_6a_io_stats_fops);
+	debugfs_create_bool("state_defer", 0600, csroot->d_parent,
+			    &spanel->state.enabled);
+	debugfs_create_u32("state_spilled", 0600, csroot->d_parent,
+			   &spanel->state.spilled);
+	debugfs_create_file_unsafe("esd_period_ms", 0600, csroot->d_parent, ctx,
+				   &s6e3fc3_6a_esd_period_fops);
+	debugfs_create_file("esd", 0600, csroot->d_parent, ctx,
+			    &s6e3fc3_6a_esd_fops);
 }
 
 static void s6e3fc3_6a_panel_init(struct exynos_panel *ctx)
@@ -452,10 +3599,9 @@ static void s6e3fc3_6a_panel_init(struct exynos_panel *ctx)
 
 	exynos_panel_debugfs_create_cmdset(ctx, csroot,
 					   &s6e3fc3_6a_init_cmd_set, "init");
+	s6e3fc3_6a_debugfs_init(ctx, csroot);
 
-	if (ctx->panel_rev >= PANEL_REV_EVT1_1)
-		if (!s6e3fc3_6a_lhbm_gamma_read(ctx))
-			s6e3fc3_6a_lhbm_gamma_write(ctx);
+	s6e3fc3_6a_lhbm_gamma_init(ctx);
 }
 
 static void s6e3fc3_6a_get_panel_rev(struct exynos_panel *ctx, u32 id)
@@ -579,7 +3725,7 @@ static const struct exynos_panel_mode s6e3fc3_6a_lp_mode = {
 };
 
 static const struct drm_panel_funcs s6e3fc3_6a_drm_funcs = {
-	.disable = exynos_panel_disable,
+	.disable = s6e3fc3_6a_disable,
 	.unprepare = exynos_panel_unprepare,
 	.prepare = exynos_panel_prepare,
 	.enable = s6e3fc3_6a_enable,
@@ -587,10 +3733,10 @@ static const struct drm_panel_funcs s6e3fc3_6a_drm_funcs = {
 };
 
 static const struct exynos_panel_funcs s6e3fc3_6a_exynos_funcs = {
-	.set_brightness = exynos_panel_set_brightness,
-	.set_lp_mode = exynos_panel_set_lp_mode,
+	.set_brightness = s6e3fc3_6a_set_brightness,
+	.set_lp_mode = s6e3fc3_6a_set_lp_mode,
 	.set_nolp_mode = s6e3fc3_6a_set_nolp_mode,
-	.set_binned_lp = exynos_panel_set_binned_lp,
+	.set_binned_lp = s6e3fc3_6a_set_binned_lp,
 	.set_hbm_mode = s6e3fc3_6a_set_hbm_mode,
 	.set_dimming_on = s6e3fc3_6a_set_dimming_on,
 	.set_local_hbm_mode = s6e3fc3_6a_set_local_hbm_mode,
@@ -601,6 +3747,7 @@ static const struct exynos_panel_funcs s6e3fc3_6a_exynos_funcs = {
 	.get_te2_edges = exynos_panel_get_te2_edges,
 	.configure_te2_edges = exynos_panel_configure_te2_edges,
 	.update_te2 = s6e3fc3_6a_update_te2,
+	.commit_done = s6e3fc3_6a_commit_done,
 };
 
 const struct brightness_capability s6e3fc3_6a_brightness_capability = {
@@ -660,22 +3807,96 @@ const struct exynos_panel_desc samsung_s6e3fc3_6a = {
 	.exynos_panel_func = &s6e3fc3_6a_exynos_funcs,
 };
 
+static int s6e3fc3_6a_panel_probe(struct mipi_dsi_device *dsi)
+{
+	struct s6e3fc3_6a_panel *spanel;
+	int ret;
+
+	spanel = devm_kzalloc(&dsi->dev, sizeof(*spanel), GFP_KERNEL);
+	if (!spanel)
+		return -ENOMEM;
+
+	INIT_WORK(&spanel->lhbm.latency_work, s6e3fc3_6a_lhbm_latency_work);
+	INIT_DELAYED_WORK(&spanel->lhbm.gamma_work, s6e3fc3_6a_lhbm_gamma_work);
+	INIT_DELAYED_WORK(&spanel->idle.work, s6e3fc3_6a_idle_work);
+	INIT_DELAYED_WORK(&spanel->aod.work, s6e3fc3_6a_aod_work);
+	INIT_WORK(&spanel->bl_transition.work, s6e3fc3_6a_bl_transition_work);
+	INIT_DELAYED_WORK(&spanel->state.flush_work, s6e3fc3_6a_state_flush_work);
+	INIT_DELAYED_WORK(&spanel->esd.work, s6e3fc3_6a_esd_work);
+	mutex_init(&spanel->notify.lock);
+	spanel->state.enabled = true;
+	spanel->aod.bin = -1;
+	spanel->aod.hysteresis = s6e3fc3_6a_AOD_HYSTERESIS;
+	spanel->aod.min_dwell_ms = s6e3fc3_6a_AOD_MIN_DWELL_MS;
+	spanel->power_stats.since = ktime_get();
+
+	ret = s6e3fc3_6a_pps_init(&dsi->dev, spanel, of_device_get_match_data(&dsi->dev));
+	if (ret)
+		dev_warn(&dsi->dev, "using vendor PPS for all modes (%d)\n", ret);
+
+	ret = exynos_panel_common_init(dsi, &spanel->base);
+	if (ret)
+		return ret;
+
+	/* without the LUT only brightness transitions are refused */
+	if (s6e3fc3_6a_bl_lut_init(&spanel->base))
+		dev_warn(&dsi->dev, "failed to build brightness LUT\n");
+
+	ret = devm_device_add_group(&dsi->dev, &s6e3fc3_6a_attr_group);
+	if (ret)
+		dev_warn(&dsi->dev, "failed to create sysfs group (%d)\n", ret);
+
+	spanel->thermal.cdev = devm_thermal_of_cooling_device_register(&dsi->dev,
+						dsi->dev.of_node, "s6e3fc3_6a", &spanel->base,
+						&s6e3fc3_6a_cooling_ops);
+	if (IS_ERR(spanel->thermal.cdev)) {
+		dev_warn(&dsi->dev, "failed to register cooling device (%ld)\n",
+			 PTR_ERR(spanel->thermal.cdev));
+		spanel->thermal.cdev = NULL;
+	}
+
+	return 0;
+}
+
+static int s6e3fc3_6a_panel_remove(struct mipi_dsi_device *dsi)
+{
+	struct exynos_panel *ctx = mipi_dsi_get_drvdata(dsi);
+
+	cancel_work_sync(&to_spanel(ctx)->lhbm.latency_work);
+	cancel_delayed_work_sync(&to_spanel(ctx)->lhbm.gamma_work);
+	cancel_delayed_work_sync(&to_spanel(ctx)->idle.work);
+	cancel_delayed_work_sync(&to_spanel(ctx)->aod.work);
+	cancel_work_sync(&to_spanel(ctx)->bl_transition.work);
+	cancel_delayed_work_sync(&to_spanel(ctx)->state.flush_work);
+	cancel_delayed_work_sync(&to_spanel(ctx)->esd.work);
+
+	return exynos_panel_remove(dsi);
+}
+
 static const struct of_device_id exynos_panel_of_match[] = {
 	{ .compatible = "samsung,s6e3fc3_6a", .data = &samsung_s6e3fc3_6a },
 	{ }
 };
-MODULE_DEVICE_TABLE(of, exynos_panel_of_match);
 
 static struct mipi_dsi_driver exynos_panel_driver = {
-	.probe = exynos_panel_probe,
-	.remove = exynos_panel_remove,
+	.probe = s6e3fc3_6a_panel_probe,
+	.remove = s6e3fc3_6a_panel_remove,
 	.driver = {
 		.name = "panel-samsung-s6e3fc3_6a",
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 		.of_match_table = exynos_panel_of_match,
 	},
 };
+
+/*
+ * panel-samsung-s6e3fc3_6a-test.c builds this file into the KUnit module, which
+ * must neither bind to the panel nor export the notifier a second time.
+ */
+#ifndef s6e3fc3_6a_KUNIT_TEST
+MODULE_DEVICE_TABLE(of, exynos_panel_of_match);
 module_mipi_dsi_driver(exynos_panel_driver);
 
 MODULE_AUTHOR("Jiun Yu <jiun.yu@samsung.com>");
 MODULE_DESCRIPTION("MIPI-DSI based Samsung s6e3fc3_6a panel driver");
 MODULE_LICENSE("GPL");
+#endif
@@ -0,0 +1,59 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Display state published by the s6e3fc3_6a panel driver to its peers,
+ * e.g. the touch controller referencing the panel through st,panel_map.
+ *
+ * Copyright 2021 Google LLC
+ */
+
+#ifndef _PANEL_SAMSUNG_S6E3FC3_6A_H_
+#define _PANEL_SAMSUNG_S6E3FC3_6A_H_
+
+#include <linux/ktime.h>
+#include <linux/notifier.h>
+#include <linux/types.h>
+
+struct device;
+
+/**
+ * enum s6e3fc3_6a_notify_event - notifier chain events
+ * @s6e3fc3_6a_NOTIFY_STATE: refresh rate, power state or TE2 edges changed,
+ *			     data is a struct s6e3fc3_6a_notify_data
+ */
+enum s6e3fc3_6a_notify_event {
+	s6e3fc3_6a_NOTIFY_STATE,
+};
+
+/**
+ * struct s6e3fc3_6a_notify_data - display state at the time of the event
+ */
+struct s6e3fc3_6a_notify_data {
+	/** @dev: panel device, matches the node in st,panel_map */
+	struct device *dev;
+	/** @vrefresh: refresh rate the panel runs at, 0 while the panel is off */
+	u32 vrefresh;
+	/** @te: time of the last TE seen by the DPU, 0 if none yet */
+	ktime_t te;
+	/** @te_period_us: TE period, add multiples of it to @te to find the next TE */
+	u32 te_period_us;
+	/** @lp: panel is in LP (AOD) mode */
+	bool lp;
+	/** @hbm: HBM is on */
+	bool hbm;
+	/** @lhbm: local HBM is on */
+	bool lhbm;
+	/** @te2_rising: TE2 rising edge programmed for the current mode, in lines */
+	u32 te2_rising;
+	/** @te2_falling: TE2 falling edge programmed for the current mode, in lines */
+	u32 te2_falling;
+};
+
+/*
+ * Callbacks run in process context and one at a time, from within the panel
+ * callbacks. The panel mode lock may or may not be held, so they must not call
+ * back into the panel driver.
+ */
+int s6e3fc3_6a_register_notifier(struct notifier_block *nb);
+int s6e3fc3_6a_unregister_notifier(struct notifier_block *nb);
+
+#endif /* _PANEL_SAMSUNG_S6E3FC3_6A_H_ */